@@ -1,12 +1,17 @@
 #include "AngelScriptExporter.h"
 #include <angelscript.h>
 #include <rapidjson/document.h>
+#include <rapidjson/reader.h>
 #include <rapidjson/filewritestream.h>
 #include <rapidjson/filereadstream.h>
 #include <rapidjson/ostreamwrapper.h>
 #include <rapidjson/writer.h>
 #include <fstream>
 #include <map>
+#include <mutex>
+#include <vector>
+#include <string.h>
+#include <assert.h>
 
 using namespace rapidjson;
 
@@ -229,7 +234,6 @@ namespace AngelScriptExporter {
 			Value func = FormatEngineFunction(asFunc, engine, output.GetAllocator());
 			globalFuncs.PushBack(func, output.GetAllocator());
 		}
-		output.AddMember("GlobalFunctions", globalFuncs, output.GetAllocator());
 
 		//types
 		uint32_t typeCount = engine->GetObjectTypeCount();
@@ -324,7 +328,6 @@ namespace AngelScriptExporter {
 			type.AddMember("Methods", methods, output.GetAllocator());
 			globalTypes.PushBack(type, output.GetAllocator());
 		}
-		output.AddMember("GlobalTypes", globalTypes, output.GetAllocator());
 		//func defs
 		uint32_t funcdefCount = engine->GetFuncdefCount();
 		Value globalFuncDefs = Value(kArrayType);
@@ -339,7 +342,6 @@ namespace AngelScriptExporter {
 			funcdef.AddMember("Namespace", namespaceVal ? Value(namespaceVal, output.GetAllocator()) : Value(""), output.GetAllocator());
 			globalFuncDefs.PushBack(funcdef, output.GetAllocator());
 		}
-		output.AddMember("GlobalFuncDefs", globalFuncDefs, output.GetAllocator());
 		//typedefs
 		uint32_t typedefCount = engine->GetTypedefCount();
 		Value globalTypedefs = Value(kArrayType);
@@ -355,7 +357,6 @@ namespace AngelScriptExporter {
 			typeDef.AddMember("Namespace", namespaceVal ? Value(namespaceVal, output.GetAllocator()) : Value(""), output.GetAllocator());
 			globalTypedefs.PushBack(typeDef, output.GetAllocator());
 		}
-		output.AddMember("GlobalTypeDefs", globalTypedefs, output.GetAllocator());
 		//enums
 		uint32_t enumCount = engine->GetEnumCount();
 		Value globalEnums = Value(kArrayType);
@@ -376,7 +377,6 @@ namespace AngelScriptExporter {
 			enumVal.AddMember("Name", Value(asType->GetName(), output.GetAllocator()), output.GetAllocator());
 			globalEnums.PushBack(enumVal, output.GetAllocator());
 		}
-		output.AddMember("GlobalEnums", globalEnums, output.GetAllocator());
 		//properties
 		uint32_t propCount = engine->GetGlobalPropertyCount();
 		Value globalProps = Value(kArrayType);
@@ -395,7 +395,11 @@ namespace AngelScriptExporter {
 			prop.AddMember("Declaration", Value(engine->GetTypeDeclaration(typeID), output.GetAllocator()), output.GetAllocator());
 			globalProps.PushBack(prop, output.GetAllocator());
 		}
-		output.AddMember("GlobalProperties", globalProps, output.GetAllocator());
+		//sections are written in registration order so the importer can stream them
+		output.AddMember("Ordered", Value(true), output.GetAllocator());
+		output.AddMember("GlobalEnums", globalEnums, output.GetAllocator());
+		output.AddMember("GlobalTypeDefs", globalTypedefs, output.GetAllocator());
+		output.AddMember("GlobalTypes", globalTypes, output.GetAllocator());
 		//String factory type
 		{
 			int stringTypeID = engine->GetStringFactoryReturnTypeId();
@@ -418,6 +422,9 @@ namespace AngelScriptExporter {
 				}
 			}
 		}
+		output.AddMember("GlobalFuncDefs", globalFuncDefs, output.GetAllocator());
+		output.AddMember("GlobalProperties", globalProps, output.GetAllocator());
+		output.AddMember("GlobalFunctions", globalFuncs, output.GetAllocator());
 
 		//write to file
 		std::ofstream outFile(file);
@@ -431,6 +438,7 @@ namespace AngelScriptExporter {
 	public:
 		StringFactory() {}
 		const void* GetStringConstant(const char* data, AngelScript::asUINT length) {
+			std::lock_guard<std::mutex> lock(mutex);
 			std::string str(data, length);
 			auto& it = stringCache.find(str);
 			if (it != stringCache.end())
@@ -441,6 +449,7 @@ namespace AngelScriptExporter {
 			return reinterpret_cast<const void*>(&it->first);
 		}
 		int ReleaseStringConstant(const void* str) {
+			std::lock_guard<std::mutex> lock(mutex);
 			int ret = AngelScript::asSUCCESS;
 
 			std::map<std::string, int>::iterator it = stringCache.find(*reinterpret_cast<const std::string*>(str));
@@ -467,20 +476,13 @@ namespace AngelScriptExporter {
 		}
 	private:
 		std::map<std::string, int> stringCache;
+		std::mutex mutex;
 	};
-	static StringFactory* dummyStringFactory = nullptr;
-
-	class DummyStringFactoryCleaner {
-	public:
-		~DummyStringFactoryCleaner() {
-			if (dummyStringFactory) {
-				delete dummyStringFactory;
-				dummyStringFactory = 0;
-			}
-		}
-	};
-
-	static DummyStringFactoryCleaner cleaner;
+	//Shared by every engine that imports an interface, engines may be used from several threads
+	static StringFactory* GetDummyStringFactory() {
+		static StringFactory dummyStringFactory;
+		return &dummyStringFactory;
+	}
 	//This function is here to allow arrays to be used. copied from scriptrarray.cpp
 	static bool ScriptArrayTemplateCallback(asITypeInfo* ti, bool& dontGarbageCollect) {
 		// Make sure the subtype can be instantiated with a default factory/constructor,
@@ -576,141 +578,917 @@ namespace AngelScriptExporter {
 		return true;
 	}
 
-	void ImportEngineFromJson(const char* file, asIScriptEngine* engine) {
+	//Binary interface image
+	//The image is a flat list of records in the order they have to be registered in.
+	//Strings are stored null terminated so they can be handed to the engine straight from the file buffer.
+	static const uint32_t BINARY_INTERFACE_MAGIC = 0x49485341; //"ASHI"
+	static const uint32_t BINARY_INTERFACE_VERSION = 3;
+	//magic, version, size of the records after the header and a reserved 0
+	static const uint32_t BINARY_INTERFACE_HEADER_SIZE = 16;
+
+	enum BinaryRecord : uint8_t {
+		RECORD_END = 0,
+		RECORD_NAMESPACE,
+		RECORD_ENUM,
+		RECORD_ENUM_VALUE,
+		RECORD_TYPEDEF,
+		RECORD_OBJECT_TYPE,
+		RECORD_INTERFACE,
+		RECORD_BEHAVIOUR,
+		RECORD_STRING_FACTORY,
+		RECORD_DEFAULT_ARRAY,
+		RECORD_FUNCDEF,
+		RECORD_OBJECT_PROPERTY,
+		RECORD_OBJECT_METHOD,
+		RECORD_INTERFACE_METHOD,
+		RECORD_GLOBAL_PROPERTY,
+		RECORD_GLOBAL_FUNCTION
+	};
+
+	class BinaryWriter {
+	public:
+		void Record(BinaryRecord r) {
+			data.push_back((char)r);
+		}
+		void Int(int32_t v) {
+			data.append((const char*)&v, sizeof(v));
+		}
+		void String(const char* s) {
+			if (!s) {
+				s = "";
+			}
+			uint32_t length = (uint32_t)strlen(s);
+			Int((int32_t)length);
+			data.append(s, length + 1);
+		}
+		std::string data;
+	};
+
+	class BinaryReader {
+	public:
+		BinaryReader(const char* data, size_t size) : data(data), size(size), pos(0), overrun(false) {}
+		BinaryRecord Record() {
+			if (pos + 1 > size) {
+				overrun = true;
+				return RECORD_END;
+			}
+			return (BinaryRecord)data[pos++];
+		}
+		int32_t Int() {
+			int32_t v = 0;
+			if (pos + sizeof(v) <= size) {
+				memcpy(&v, data + pos, sizeof(v));
+				pos += sizeof(v);
+			} else {
+				overrun = true;
+			}
+			return v;
+		}
+		const char* String() {
+			uint32_t length = (uint32_t)Int();
+			if (overrun || length >= size - pos || data[pos + length] != 0) {
+				overrun = true;
+				pos = size;
+				return "";
+			}
+			const char* s = data + pos;
+			pos += length + 1;
+			return s;
+		}
+		//true if a read went past the end of the data, i.e. the image is truncated
+		bool Overrun() const {
+			return overrun;
+		}
+	private:
+		const char* data;
+		size_t size;
+		size_t pos;
+		bool overrun;
+	};
+
+	//Same declaration fixup as the JSON export does for behaviours
+	static std::string FormatBehaviourDeclaration(asIScriptFunction* asFunc, asEBehaviours behaviour) {
+		std::string decl = asFunc->GetDeclaration(false);
+		if (behaviour == AngelScript::asBEHAVE_CONSTRUCT) {
+			decl = std::string("void ") + decl;
+		} else if (behaviour == AngelScript::asBEHAVE_DESTRUCT) {
+			decl.erase(0, 1);
+			decl = std::string("void ") + decl;
+		}
+		size_t n = decl.find("$");
+		if (n != std::string::npos)
+			decl[n] = ' ';
+		return decl;
+	}
+
+	void ExportEngineAsBinary(const char* file, asIScriptEngine* engine) {
+		engine->SetEngineProperty(AngelScript::asEP_EXPAND_DEF_ARRAY_TO_TMPL, true);
+		BinaryWriter out;
+		out.Int((int32_t)BINARY_INTERFACE_MAGIC);
+		out.Int((int32_t)BINARY_INTERFACE_VERSION);
+		out.Int(0); //size, filled in at the end
+		out.Int(0);
+
+		//enums
+		uint32_t enumCount = engine->GetEnumCount();
+		for (uint32_t i = 0; i < enumCount; ++i) {
+			asITypeInfo* asType = engine->GetEnumByIndex(i);
+			out.Record(RECORD_NAMESPACE);
+			out.String(asType->GetNamespace());
+			out.Record(RECORD_ENUM);
+			out.String(asType->GetName());
+			uint32_t enumValCount = asType->GetEnumValueCount();
+			for (uint32_t k = 0; k < enumValCount; ++k) {
+				int val;
+				const char* name = asType->GetEnumValueByIndex(k, &val);
+				out.Record(RECORD_ENUM_VALUE);
+				out.String(asType->GetName());
+				out.String(name);
+				out.Int(val);
+			}
+		}
+		//typedefs
+		uint32_t typedefCount = engine->GetTypedefCount();
+		for (uint32_t i = 0; i < typedefCount; ++i) {
+			asITypeInfo* asType = engine->GetTypedefByIndex(i);
+			out.Record(RECORD_NAMESPACE);
+			out.String(asType->GetNamespace());
+			out.Record(RECORD_TYPEDEF);
+			out.String(asType->GetName());
+			out.String(FormatType(asType->GetTypedefTypeId(), engine, nullptr).c_str());
+		}
+		//types and their behaviours
+		uint32_t typeCount = engine->GetObjectTypeCount();
+		for (uint32_t i = 0; i < typeCount; ++i) {
+			asITypeInfo* asType = engine->GetObjectTypeByIndex(i);
+			uint32_t flags = (uint32_t)asType->GetFlags() & AngelScript::asOBJ_MASK_VALID_FLAGS;
+			std::string decl = engine->GetTypeDeclaration(asType->GetTypeId());
+			out.Record(RECORD_NAMESPACE);
+			out.String(asType->GetNamespace());
+			if (flags & AngelScript::asOBJ_SCRIPT_OBJECT) {
+				out.Record(RECORD_INTERFACE);
+				out.String(decl.c_str());
+			} else {
+				out.Record(RECORD_OBJECT_TYPE);
+				out.String(decl.c_str());
+				out.Int((int32_t)flags);
+			}
+			uint32_t behaviourCount = asType->GetBehaviourCount();
+			for (uint32_t k = 0; k < behaviourCount; ++k) {
+				asEBehaviours behaviour;
+				asIScriptFunction* asFunc = asType->GetBehaviourByIndex(k, &behaviour);
+				if (asFunc) {
+					out.Record(RECORD_BEHAVIOUR);
+					out.String(decl.c_str());
+					out.Int(behaviour);
+					out.String(FormatBehaviourDeclaration(asFunc, behaviour).c_str());
+				}
+			}
+			uint32_t factoryCount = asType->GetFactoryCount();
+			for (uint32_t k = 0; k < factoryCount; ++k) {
+				asIScriptFunction* asFunc = asType->GetFactoryByIndex(k);
+				if (asFunc) {
+					out.Record(RECORD_BEHAVIOUR);
+					out.String(decl.c_str());
+					out.Int(AngelScript::asBEHAVE_FACTORY);
+					out.String(FormatBehaviourDeclaration(asFunc, AngelScript::asBEHAVE_FACTORY).c_str());
+				}
+			}
+		}
+		out.Record(RECORD_NAMESPACE);
+		out.String("");
+		//String factory type
+		{
+			asITypeInfo* stringType = engine->GetTypeInfoById(engine->GetStringFactoryReturnTypeId());
+			if (stringType && stringType->GetName()) {
+				out.Record(RECORD_STRING_FACTORY);
+				out.String(stringType->GetName());
+			}
+		}
+		//Default Array type
+		{
+			int arrayTypeID = engine->GetDefaultArrayTypeId();
+			if (engine->GetTypeInfoById(arrayTypeID)) {
+				const char* name = engine->GetTypeDeclaration(arrayTypeID);
+				if (name) {
+					out.Record(RECORD_DEFAULT_ARRAY);
+					out.String(name);
+				}
+			}
+		}
+		//func defs
+		uint32_t funcdefCount = engine->GetFuncdefCount();
+		for (uint32_t i = 0; i < funcdefCount; ++i) {
+			asIScriptFunction* func = engine->GetFuncdefByIndex(i)->GetFuncdefSignature();
+			out.Record(RECORD_NAMESPACE);
+			out.String(func->GetNamespace());
+			out.Record(RECORD_FUNCDEF);
+			out.String(func->GetDeclaration());
+		}
+		//properties and methods, now that all types are known
+		for (uint32_t i = 0; i < typeCount; ++i) {
+			asITypeInfo* asType = engine->GetObjectTypeByIndex(i);
+			uint32_t flags = (uint32_t)asType->GetFlags() & AngelScript::asOBJ_MASK_VALID_FLAGS;
+			std::string decl = engine->GetTypeDeclaration(asType->GetTypeId());
+			out.Record(RECORD_NAMESPACE);
+			out.String(asType->GetNamespace());
+			uint32_t propCount = asType->GetPropertyCount();
+			for (uint32_t k = 0; k < propCount; ++k) {
+				out.Record(RECORD_OBJECT_PROPERTY);
+				out.String(decl.c_str());
+				out.String(asType->GetPropertyDeclaration(k));
+				out.Int((int32_t)k);
+			}
+			uint32_t methodCount = asType->GetMethodCount();
+			for (uint32_t k = 0; k < methodCount; ++k) {
+				asIScriptFunction* asFunc = asType->GetMethodByIndex(k);
+				if (asFunc) {
+					out.Record((flags & AngelScript::asOBJ_SCRIPT_OBJECT) ? RECORD_INTERFACE_METHOD : RECORD_OBJECT_METHOD);
+					out.String(decl.c_str());
+					out.String(asFunc->GetDeclaration(false));
+				}
+			}
+		}
+		//properties
+		uint32_t propCount = engine->GetGlobalPropertyCount();
+		for (uint32_t i = 0; i < propCount; ++i) {
+			const char* name;
+			const char* namespaceVal;
+			bool isConst;
+			int typeID;
+			engine->GetGlobalPropertyByIndex(i, &name, &namespaceVal, &typeID, &isConst);
+			std::string decl = isConst ? "const " : "";
+			decl += engine->GetTypeDeclaration(typeID, true);
+			decl += " ";
+			decl += name ? name : "";
+			out.Record(RECORD_NAMESPACE);
+			out.String(namespaceVal);
+			out.Record(RECORD_GLOBAL_PROPERTY);
+			out.String(decl.c_str());
+		}
+		//global functions
+		uint32_t globalFuncCount = engine->GetGlobalFunctionCount();
+		for (uint32_t i = 0; i < globalFuncCount; ++i) {
+			asIScriptFunction* asFunc = engine->GetGlobalFunctionByIndex(i);
+			out.Record(RECORD_NAMESPACE);
+			out.String(asFunc->GetNamespace());
+			out.Record(RECORD_GLOBAL_FUNCTION);
+			out.String(asFunc->GetDeclaration(false));
+		}
+		out.Record(RECORD_NAMESPACE);
+		out.String("");
+		out.Record(RECORD_END);
+		uint32_t recordSize = (uint32_t)(out.data.size() - BINARY_INTERFACE_HEADER_SIZE);
+		memcpy(&out.data[8], &recordSize, sizeof(recordSize));
+
+		FILE* fout = fopen(file, "wb");
+		if (!fout) {
+			return;
+		}
+		fwrite(out.data.data(), 1, out.data.size(), fout);
+		fclose(fout);
+	}
+
+	//Global properties are never accessed by a compile only engine, they just need a valid address
+	static uint64_t dummyPropertyStorage[2];
+
+	//Registers a single entity of the interface, shared by the binary and the json importer
+	static int RegisterRecord(asIScriptEngine* engine, BinaryRecord record, const char* a, const char* b, int value) {
+		switch (record) {
+		case RECORD_NAMESPACE:
+			return engine->SetDefaultNamespace(a);
+		case RECORD_ENUM:
+			return engine->RegisterEnum(a);
+		case RECORD_ENUM_VALUE:
+			return engine->RegisterEnumValue(a, b, value);
+		case RECORD_TYPEDEF:
+			return engine->RegisterTypedef(a, b);
+		case RECORD_OBJECT_TYPE:
+			return engine->RegisterObjectType(a, (value & AngelScript::asOBJ_VALUE) ? 1 : 0, value);
+		case RECORD_INTERFACE:
+			return engine->RegisterInterface(a);
+		case RECORD_BEHAVIOUR:
+			if (value == AngelScript::asBEHAVE_TEMPLATE_CALLBACK) {
+				return engine->RegisterObjectBehaviour(a, (asEBehaviours)value, b, AngelScript::asFUNCTION(ScriptArrayTemplateCallback), AngelScript::asCALL_CDECL);
+			}
+			return engine->RegisterObjectBehaviour(a, (asEBehaviours)value, b, AngelScript::asFUNCTION(0), AngelScript::asCALL_GENERIC);
+		case RECORD_STRING_FACTORY:
+			return engine->RegisterStringFactory(a, GetDummyStringFactory());
+		case RECORD_DEFAULT_ARRAY:
+			return engine->RegisterDefaultArrayType(a);
+		case RECORD_FUNCDEF:
+			return engine->RegisterFuncdef(a);
+		case RECORD_OBJECT_PROPERTY:
+			return engine->RegisterObjectProperty(a, b, value);
+		case RECORD_OBJECT_METHOD:
+			return engine->RegisterObjectMethod(a, b, AngelScript::asFUNCTION(0), AngelScript::asCALL_GENERIC);
+		case RECORD_INTERFACE_METHOD:
+			return engine->RegisterInterfaceMethod(a, b);
+		case RECORD_GLOBAL_PROPERTY:
+			return engine->RegisterGlobalProperty(a, dummyPropertyStorage);
+		case RECORD_GLOBAL_FUNCTION:
+			return engine->RegisterGlobalFunction(a, AngelScript::asFUNCTION(0), AngelScript::asCALL_GENERIC);
+		default:
+			return AngelScript::asINVALID_ARG;
+		}
+	}
+
+	BinaryImportResult ImportEngineFromBinary(const char* file, asIScriptEngine* engine) {
 		FILE* fin = fopen(file, "rb");
 		if (!fin) {
-			return;
+			return BINARY_IMPORT_NOT_BINARY;
 		}
-		fseek(fin, 0, SEEK_END);
-		uint32_t size = ftell(fin);
-		fseek(fin, 0, SEEK_SET);
-		char* buffer = (char*)malloc(size);
-		if (!buffer) {
-			return;
+		//only the header is read from files that aren't binary images, the json importer streams the rest
+		uint32_t header[BINARY_INTERFACE_HEADER_SIZE / 4];
+		if (fread(header, 1, sizeof(header), fin) != sizeof(header) || header[0] != BINARY_INTERFACE_MAGIC) {
+			fclose(fin);
+			return BINARY_IMPORT_NOT_BINARY;
+		}
+		if (header[1] != BINARY_INTERFACE_VERSION) {
+			fclose(fin);
+			engine->WriteMessage(file, 0, 0, AngelScript::asMSGTYPE_ERROR, "Unsupported version of the binary interface image, export it again");
+			return BINARY_IMPORT_CORRUPT;
 		}
-		rapidjson::Document document;
-		rapidjson::FileReadStream stream(fin, buffer, size);
-		document.ParseStream(stream);
+		//the size comes from the header, a file that is shorter than it says is truncated
+		std::vector<char> buffer(header[2]);
+		size_t read = buffer.empty() ? 0 : fread(buffer.data(), 1, buffer.size(), fin);
 		fclose(fin);
-		if (document.HasParseError()) {
-			return;
+		if (read != buffer.size()) {
+			engine->WriteMessage(file, 0, 0, AngelScript::asMSGTYPE_ERROR, "The binary interface image is truncated");
+			return BINARY_IMPORT_CORRUPT;
 		}
+
+		BinaryReader in(buffer.data(), buffer.size());
 		int r = 0;
-		if (document.HasMember("GlobalEnums")) {
-			const Value& globalEnums = document["GlobalEnums"];
-			for (const auto& e : globalEnums.GetArray()) {
-				const char* name = e["Name"].GetString();
-				r = engine->RegisterEnum(name);
-				assert(r >= 0);
-				const Value& values = e["Values"];
-				for (auto& v : values.GetArray()) {
-					r = engine->RegisterEnumValue(name, v["Name"].GetString(), v["Value"].GetInt());
-					assert(r >= 0);
-				}
+		for (BinaryRecord record = in.Record(); record != RECORD_END; record = in.Record()) {
+			const char* a = "";
+			const char* b = "";
+			int value = 0;
+			switch (record) {
+			case RECORD_NAMESPACE:
+			case RECORD_ENUM:
+			case RECORD_INTERFACE:
+			case RECORD_STRING_FACTORY:
+			case RECORD_DEFAULT_ARRAY:
+			case RECORD_FUNCDEF:
+			case RECORD_GLOBAL_PROPERTY:
+			case RECORD_GLOBAL_FUNCTION:
+				a = in.String();
+				break;
+			case RECORD_TYPEDEF:
+			case RECORD_OBJECT_METHOD:
+			case RECORD_INTERFACE_METHOD:
+				a = in.String();
+				b = in.String();
+				break;
+			case RECORD_ENUM_VALUE:
+			case RECORD_OBJECT_PROPERTY:
+				a = in.String();
+				b = in.String();
+				value = in.Int();
+				break;
+			case RECORD_OBJECT_TYPE:
+				a = in.String();
+				value = in.Int();
+				break;
+			case RECORD_BEHAVIOUR:
+				a = in.String();
+				value = in.Int();
+				b = in.String();
+				break;
+			default:
+				//unknown record, the image is corrupt
+				engine->SetDefaultNamespace("");
+				engine->WriteMessage(file, 0, 0, AngelScript::asMSGTYPE_ERROR, "The binary interface image is corrupt");
+				return BINARY_IMPORT_CORRUPT;
+			}
+			if (in.Overrun()) {
+				break;
 			}
+			r = RegisterRecord(engine, record, a, b, value);
+			assert(r >= 0);
 		}
-		if (document.HasMember("GlobalTypeDefs")) {
-			const Value& globalTypeDefs = document["GlobalTypeDefs"];
-			for (const auto& typeDef : globalTypeDefs.GetArray()) {
-				r = engine->RegisterTypedef(typeDef["Name"].GetString(), typeDef["Type"].GetString());
-				assert(r >= 0);
+		engine->SetDefaultNamespace("");
+		if (in.Overrun()) {
+			engine->WriteMessage(file, 0, 0, AngelScript::asMSGTYPE_ERROR, "The binary interface image is corrupt");
+			return BINARY_IMPORT_CORRUPT;
+		}
+		return BINARY_IMPORT_OK;
+	}
+
+	/*
+	Streaming json importer. Entries are registered as they come out of the Reader, only the entry that is currently
+	being read is kept in memory. Registrations have to happen in the order below, anything that shows up before the
+	sections it depends on are done is put in a queue of declarations until they are. Type members always wait for the
+	funcdefs, everything else streams straight through for files written by ExportEngineAsJSON, which marks its files
+	as "Ordered". Other files work as well, they just queue more.
+	*/
+	enum ImportStage {
+		STAGE_ENUMS = 0,
+		STAGE_TYPEDEFS,
+		STAGE_TYPES,
+		STAGE_STRING_FACTORY,
+		STAGE_DEFAULT_ARRAY,
+		STAGE_FUNCDEFS,
+		STAGE_MEMBERS,
+		STAGE_PROPERTIES,
+		STAGE_FUNCTIONS,
+		STAGE_COUNT,
+		STAGE_NONE = STAGE_COUNT
+	};
+
+	static ImportStage GetSectionStage(const std::string& key) {
+		if (key == "GlobalEnums") return STAGE_ENUMS;
+		if (key == "GlobalTypeDefs") return STAGE_TYPEDEFS;
+		if (key == "GlobalTypes") return STAGE_TYPES;
+		if (key == "StringFactoryType") return STAGE_STRING_FACTORY;
+		if (key == "DefaultArrayType") return STAGE_DEFAULT_ARRAY;
+		if (key == "GlobalFuncDefs") return STAGE_FUNCDEFS;
+		if (key == "GlobalProperties") return STAGE_PROPERTIES;
+		if (key == "GlobalFunctions") return STAGE_FUNCTIONS;
+		return STAGE_NONE;
+	}
+
+	static ImportStage GetRecordStage(BinaryRecord record) {
+		switch (record) {
+		case RECORD_ENUM:
+		case RECORD_ENUM_VALUE:
+			return STAGE_ENUMS;
+		case RECORD_TYPEDEF:
+			return STAGE_TYPEDEFS;
+		case RECORD_OBJECT_TYPE:
+		case RECORD_INTERFACE:
+		case RECORD_BEHAVIOUR:
+			return STAGE_TYPES;
+		case RECORD_STRING_FACTORY:
+			return STAGE_STRING_FACTORY;
+		case RECORD_DEFAULT_ARRAY:
+			return STAGE_DEFAULT_ARRAY;
+		case RECORD_FUNCDEF:
+			return STAGE_FUNCDEFS;
+		case RECORD_OBJECT_PROPERTY:
+		case RECORD_OBJECT_METHOD:
+		case RECORD_INTERFACE_METHOD:
+			return STAGE_MEMBERS;
+		case RECORD_GLOBAL_PROPERTY:
+			return STAGE_PROPERTIES;
+		default:
+			return STAGE_FUNCTIONS;
+		}
+	}
+
+	class StreamingImporter : public BaseReaderHandler<UTF8<>, StreamingImporter> {
+	public:
+		StreamingImporter(asIScriptEngine* engine) : engine(engine), ordered(false), finished(false), section(STAGE_NONE), highestSection(-1) {
+			for (int i = 0; i < STAGE_COUNT; ++i) {
+				completed[i] = false;
 			}
 		}
 
-		if (document.HasMember("GlobalTypes")) {
-			const Value& globalTypes = document["GlobalTypes"];
-			for (const auto& type : globalTypes.GetArray()) {
-				int flags = type["Flags"].GetInt();
-				const char* decl = type["Declaration"].GetString();
-				const char* space = type["Namespace"].GetString();
-				engine->SetDefaultNamespace(space);
+		//Everything left in the queue is registered once the whole file has been read
+		void Finish() {
+			finished = true;
+			Flush();
+			engine->SetDefaultNamespace("");
+		}
 
-				if (flags & AngelScript::asOBJ_SCRIPT_OBJECT) {
-					r = engine->RegisterInterface(decl);
-				} else {
-					r = engine->RegisterObjectType(decl, (flags & AngelScript::asOBJ_VALUE) ? 1 : 0, flags);
+		bool Null() { return true; }
+		bool Bool(bool b) {
+			std::string field = Field();
+			if (field == "Ordered") {
+				ordered = b;
+			} else if (field == "GlobalProperties/Const") {
+				entry.isConst = b;
+			}
+			return true;
+		}
+		bool Int(int i) { return Number(i); }
+		bool Uint(unsigned u) { return Number(u); }
+		bool Int64(int64_t i) { return Number(i); }
+		bool Uint64(uint64_t u) { return Number((int64_t)u); }
+		bool Double(double d) { return Number((int64_t)d); }
+
+		bool String(const char* str, SizeType length, bool) {
+			if (frames.size() == 1) {
+				//top level strings are sections on their own
+				ImportStage stage = GetSectionStage(key);
+				if (stage == STAGE_STRING_FACTORY || stage == STAGE_DEFAULT_ARRAY) {
+					BeginSection(stage);
+					Submit(stage == STAGE_STRING_FACTORY ? RECORD_STRING_FACTORY : RECORD_DEFAULT_ARRAY, "", std::string(str, length));
+					EndSection();
 				}
-				assert(r >= 0);
-				for (auto& beh : type["Behaviors"].GetArray()) {
-					asEBehaviours b = (asEBehaviours)beh["Type"].GetInt();
-					if (b == AngelScript::asBEHAVE_TEMPLATE_CALLBACK) {
-						r = engine->RegisterObjectBehaviour(decl, b, beh["Func"]["Declaration"].GetString(), AngelScript::asFUNCTION(ScriptArrayTemplateCallback), AngelScript::asCALL_CDECL);
-					} else {
-						r = engine->RegisterObjectBehaviour(decl, b, beh["Func"]["Declaration"].GetString(), AngelScript::asFUNCTION(0), AngelScript::asCALL_GENERIC);
-					}
-					assert(r >= 0);
+				return true;
+			}
+			std::string field = Field();
+			std::string value(str, length);
+			if (field == "GlobalEnums/Name" || field == "GlobalTypeDefs/Name" || field == "GlobalTypes/Name" || field == "GlobalProperties/Name") {
+				entry.name = value;
+			} else if (field == "GlobalTypeDefs/Namespace" || field == "GlobalTypes/Namespace" || field == "GlobalFuncDefs/Namespace" ||
+				field == "GlobalProperties/Namespace" || field == "GlobalFunctions/Namespace") {
+				entry.nameSpace = value;
+			} else if (field == "GlobalTypes/Declaration" || field == "GlobalFuncDefs/Declaration" || field == "GlobalFunctions/Declaration") {
+				entry.declaration = value;
+			} else if (field == "GlobalTypeDefs/Type" || field == "GlobalProperties/Type") {
+				entry.type = value;
+			} else if (field == "GlobalEnums/Values/Name") {
+				entry.subName = value;
+			} else if (field == "GlobalTypes/Behaviors/Func/Declaration") {
+				entry.subDeclaration = value;
+			} else if (field == "GlobalTypes/Properties/Declaration") {
+				entry.properties.push_back(value);
+			} else if (field == "GlobalTypes/Methods/Declaration") {
+				entry.methods.push_back(value);
+			}
+			return true;
+		}
+
+		bool Key(const char* str, SizeType length, bool) {
+			key.assign(str, length);
+			return true;
+		}
+
+		bool StartObject() {
+			Push(false);
+			if (frames.size() == 3) {
+				entry = Entry();
+			}
+			return true;
+		}
+
+		bool EndObject(SizeType) {
+			if (frames.size() == 3) {
+				RegisterEntry();
+			} else if (path == "GlobalEnums/Values") {
+				entry.values.push_back(std::make_pair(entry.subName, (int)entry.subValue));
+			} else if (path == "GlobalTypes/Behaviors") {
+				if (!entry.subDeclaration.empty()) {
+					entry.behaviours.push_back(std::make_pair((int)entry.subValue, entry.subDeclaration));
 				}
-				engine->SetDefaultNamespace("");
+				entry.subDeclaration.clear();
 			}
-			
-			//Hopefully we will have registered the string type now
-			if (document.HasMember("StringFactoryType")) {
-				const Value& stringType = document["StringFactoryType"];
-				dummyStringFactory = new StringFactory();
-				r = engine->RegisterStringFactory(stringType.GetString(), dummyStringFactory);
-				assert(r >= 0);
-			}
-			//Hopefully we will have registered the array type
-			if (document.HasMember("DefaultArrayType")) {
-				const Value& arrayType = document["DefaultArrayType"];
-				r = engine->RegisterDefaultArrayType(arrayType.GetString());
-				assert(r >= 0);
-			}
-			if (document.HasMember("GlobalFuncDefs")) {
-				const Value& globalFuncDefs = document["GlobalFuncDefs"];
-				for (const auto& funcDef : globalFuncDefs.GetArray()) {
-					r = engine->RegisterFuncdef(funcDef["Declaration"].GetString());
-					assert(r >= 0);
+			Pop();
+			return true;
+		}
+
+		bool StartArray() {
+			if (frames.size() == 1) {
+				BeginSection(GetSectionStage(key));
+			}
+			Push(true);
+			return true;
+		}
+
+		bool EndArray(SizeType) {
+			Pop();
+			if (frames.size() == 1) {
+				EndSection();
+			}
+			return true;
+		}
+
+	private:
+		struct Frame {
+			size_t pathLength;
+			bool isArray;
+		};
+
+		//The entry of a section array that is currently being read
+		struct Entry {
+			std::string name;
+			std::string nameSpace;
+			std::string declaration;
+			std::string type;
+			int64_t flags = 0;
+			bool isConst = false;
+			std::vector<std::pair<std::string, int>> values;
+			std::vector<std::pair<int, std::string>> behaviours;
+			std::vector<std::string> properties;
+			std::vector<std::string> methods;
+			//enum value or behaviour currently being read
+			std::string subName;
+			std::string subDeclaration;
+			int64_t subValue = 0;
+		};
+
+		struct PendingRecord {
+			BinaryRecord record;
+			std::string nameSpace;
+			std::string a;
+			std::string b;
+			int value;
+		};
+
+		bool Number(int64_t n) {
+			std::string field = Field();
+			if (field == "GlobalTypes/Flags") {
+				entry.flags = n;
+			} else if (field == "GlobalEnums/Values/Value" || field == "GlobalTypes/Behaviors/Type") {
+				entry.subValue = n;
+			}
+			return true;
+		}
+
+		//Path of the value for the current key, array elements don't add to the path
+		std::string Field() const {
+			return path.empty() ? key : path + "/" + key;
+		}
+
+		void Push(bool isArray) {
+			Frame f = { path.size(), isArray };
+			if (!frames.empty() && !frames.back().isArray) {
+				if (!path.empty()) {
+					path += "/";
 				}
+				path += key;
 			}
-			for (const auto& type : globalTypes.GetArray()) {
-				const char* name = type["Name"].GetString();
-				const char* decl = type["Declaration"].GetString();
-				int flags = type["Flags"].GetInt();
-				asITypeInfo* asType = engine->GetTypeInfoByName(name);
-				if (asType) {
-					for (auto& prop : type["Properties"].GetArray()) {
-						r = engine->RegisterObjectProperty(decl, prop["Declaration"].GetString(), asType->GetPropertyCount());
-						assert(r >= 0);
-					}
-					for (auto& method : type["Methods"].GetArray()) {
-						if (flags & AngelScript::asOBJ_SCRIPT_OBJECT) {
-							r = engine->RegisterInterfaceMethod(decl, method["Declaration"].GetString());
-							assert(r >= 0);
-						} else {
-							const char* methodDecl = method["Declaration"].GetString();
-							r = engine->RegisterObjectMethod(decl, methodDecl, AngelScript::asFUNCTION(0), AngelScript::asCALL_GENERIC);
-							assert(r >= 0);
-						}
-					}
+			frames.push_back(f);
+		}
+
+		void Pop() {
+			path.resize(frames.back().pathLength);
+			frames.pop_back();
+		}
+
+		void BeginSection(ImportStage stage) {
+			section = stage;
+			if (stage != STAGE_NONE && (int)stage > highestSection) {
+				highestSection = stage;
+				Flush();
+			}
+		}
+
+		void EndSection() {
+			if (section != STAGE_NONE) {
+				completed[section] = true;
+				Flush();
+			}
+			section = STAGE_NONE;
+		}
+
+		bool IsDone(int stage) const {
+			if (stage == STAGE_MEMBERS) {
+				//members are read as part of the types
+				return IsDone(STAGE_TYPES);
+			}
+			return finished || completed[stage] || (ordered && stage < highestSection);
+		}
+
+		bool IsReady(int stage) const {
+			for (int i = 0; i < stage; ++i) {
+				if (!IsDone(i)) {
+					return false;
 				}
 			}
+			return true;
 		}
 
+		void Register(BinaryRecord record, const std::string& nameSpace, const std::string& a, const std::string& b, int value) {
+			engine->SetDefaultNamespace(nameSpace.c_str());
+			int r = RegisterRecord(engine, record, a.c_str(), b.c_str(), value);
+			assert(r >= 0);
+		}
 
-		if (document.HasMember("GlobalProperties")) {
-			const Value& globalProps = document["GlobalProperties"];
-			for (const auto& prop : globalProps.GetArray()) {
-				engine->RegisterGlobalProperty(prop["Declaration"].GetString(), nullptr);
+		void Submit(BinaryRecord record, const std::string& nameSpace, const std::string& a, const std::string& b = "", int value = 0) {
+			ImportStage stage = GetRecordStage(record);
+			if (pending[stage].empty() && IsReady(stage)) {
+				Register(record, nameSpace, a, b, value);
+			} else {
+				PendingRecord p = { record, nameSpace, a, b, value };
+				pending[stage].push_back(p);
 			}
 		}
 
-		if (document.HasMember("GlobalFunctions")) {
-			const Value& globalFunctions = document["GlobalFunctions"];
-			for (const auto& func : globalFunctions.GetArray()) {
-				const char* space = func["Namespace"].GetString();
-				engine->SetDefaultNamespace(space);
-				r = engine->RegisterGlobalFunction(func["Declaration"].GetString(), AngelScript::asFUNCTION(0), AngelScript::asCALL_GENERIC);
-				assert(r >= 0);
-				engine->SetDefaultNamespace("");
+		void Flush() {
+			for (int stage = 0; stage < STAGE_COUNT && IsReady(stage); ++stage) {
+				for (auto& p : pending[stage]) {
+					Register(p.record, p.nameSpace, p.a, p.b, p.value);
+				}
+				pending[stage].clear();
 			}
 		}
 
-		free(buffer);
+		void RegisterEntry() {
+			switch (section) {
+			case STAGE_ENUMS:
+				Submit(RECORD_ENUM, "", entry.name);
+				for (auto& v : entry.values) {
+					Submit(RECORD_ENUM_VALUE, "", entry.name, v.first, v.second);
+				}
+				break;
+			case STAGE_TYPEDEFS:
+				Submit(RECORD_TYPEDEF, entry.nameSpace, entry.name, entry.type);
+				break;
+			case STAGE_TYPES: {
+				bool isInterface = (entry.flags & AngelScript::asOBJ_SCRIPT_OBJECT) != 0;
+				Submit(isInterface ? RECORD_INTERFACE : RECORD_OBJECT_TYPE, entry.nameSpace, entry.declaration, "", (int)entry.flags);
+				for (auto& b : entry.behaviours) {
+					Submit(RECORD_BEHAVIOUR, entry.nameSpace, entry.declaration, b.second, b.first);
+				}
+				for (size_t i = 0; i < entry.properties.size(); ++i) {
+					Submit(RECORD_OBJECT_PROPERTY, entry.nameSpace, entry.declaration, entry.properties[i], (int)i);
+				}
+				for (auto& m : entry.methods) {
+					Submit(isInterface ? RECORD_INTERFACE_METHOD : RECORD_OBJECT_METHOD, entry.nameSpace, entry.declaration, m);
+				}
+				break;
+			}
+			case STAGE_FUNCDEFS:
+				Submit(RECORD_FUNCDEF, entry.nameSpace, entry.declaration);
+				break;
+			case STAGE_PROPERTIES:
+				Submit(RECORD_GLOBAL_PROPERTY, entry.nameSpace, (entry.isConst ? "const " : "") + entry.type + " " + entry.name);
+				break;
+			case STAGE_FUNCTIONS:
+				Submit(RECORD_GLOBAL_FUNCTION, entry.nameSpace, entry.declaration);
+				break;
+			default:
+				break;
+			}
+		}
+
+		asIScriptEngine* engine;
+		bool ordered;
+		bool finished;
+		bool completed[STAGE_COUNT];
+		ImportStage section;
+		int highestSection;
+		std::vector<PendingRecord> pending[STAGE_COUNT];
+		std::vector<Frame> frames;
+		std::string path;
+		std::string key;
+		Entry entry;
+	};
+
+	void ImportEngineFromJson(const char* file, asIScriptEngine* engine) {
+		FILE* fin = fopen(file, "rb");
+		if (!fin) {
+			return;
+		}
+		char buffer[65536];
+		FileReadStream stream(fin, buffer, sizeof(buffer));
+		StreamingImporter importer(engine);
+		Reader reader;
+		reader.Parse(stream, importer);
+		fclose(fin);
+		importer.Finish();
 	}
 
 	void ExportModuleAsJSON(const char* file, AngelScript::asIScriptModule* module, asIScriptEngine* engine) {
 		Document output;
+		ReflectModule(output, module, engine);
+
+		//write to file
+		std::ofstream outFile(file);
+		OStreamWrapper wrapper(outFile);
+		Writer<OStreamWrapper> writer(wrapper);
+		output.Accept(writer);
+	}
+
+	//Script section a type was declared in, taken from its functions since types don't keep track of it
+	static const char* GetTypeSection(asITypeInfo* type) {
+		for (uint32_t i = 0; i < type->GetMethodCount(); ++i) {
+			asIScriptFunction* func = type->GetMethodByIndex(i);
+			if (func && func->GetScriptSectionName()) {
+				return func->GetScriptSectionName();
+			}
+		}
+		for (uint32_t i = 0; i < type->GetFactoryCount(); ++i) {
+			asIScriptFunction* func = type->GetFactoryByIndex(i);
+			if (func && func->GetScriptSectionName()) {
+				return func->GetScriptSectionName();
+			}
+		}
+		for (uint32_t i = 0; i < type->GetBehaviourCount(); ++i) {
+			asEBehaviours behaviour;
+			asIScriptFunction* func = type->GetBehaviourByIndex(i, &behaviour);
+			if (func && func->GetScriptSectionName()) {
+				return func->GetScriptSectionName();
+			}
+		}
+		return nullptr;
+	}
+
+	class ShardBuilder {
+	public:
+		ShardBuilder(Document& reflection) : allocator(reflection.GetAllocator()), shards(kArrayType), symbols(kArrayType) {}
+
+		//Moves value into the shard of its section, or of its namespace when the section isn't known
+		void Add(const char* array, Value& value, const char* kind, const char* section, const char* nameSpace) {
+			std::pair<std::string, std::string> key(section ? section : "", "");
+			if (key.first.empty()) {
+				key.second = nameSpace ? nameSpace : "";
+			}
+			uint32_t shard = GetShard(key);
+
+			Value symbol(kObjectType);
+			symbol.AddMember("Name", Value(value["Name"].GetString(), allocator), allocator);
+			symbol.AddMember("Namespace", Value(nameSpace ? nameSpace : "", allocator), allocator);
+			symbol.AddMember("Kind", Value(kind, allocator), allocator);
+			symbol.AddMember("Shard", Value(shard), allocator);
+			//enough to show completions without opening the shard
+			if (value.HasMember("Declaration") && strcmp(kind, "Function") == 0) {
+				symbol.AddMember("Declaration", Value(value["Declaration"].GetString(), allocator), allocator);
+			}
+			if (value.HasMember("Type")) {
+				symbol.AddMember("Type", Value(value["Type"].GetString(), allocator), allocator);
+			}
+			symbols.PushBack(symbol, allocator);
+			shards[shard][array].PushBack(value, allocator);
+		}
+
+		void Write(const char* file) {
+			std::string base = file;
+			size_t ext = base.rfind(".json");
+			if (ext != std::string::npos && ext == base.size() - 5) {
+				base.erase(ext);
+			}
+			size_t slash = base.find_last_of("/\\");
+			std::string baseName = slash == std::string::npos ? base : base.substr(slash + 1);
+
+			Document index;
+			index.SetObject();
+			index.AddMember("Sharded", Value(true), index.GetAllocator());
+			Value shardList(kArrayType);
+			for (uint32_t i = 0; i < shards.Size(); ++i) {
+				std::string shardName = baseName + "." + std::to_string(i) + ".json";
+				std::ofstream outFile(base + "." + std::to_string(i) + ".json");
+				OStreamWrapper wrapper(outFile);
+				Writer<OStreamWrapper> writer(wrapper);
+				shards[i].Accept(writer);
+
+				Value shard(kObjectType);
+				shard.AddMember("File", Value(shardName.c_str(), index.GetAllocator()), index.GetAllocator());
+				shard.AddMember("Section", Value(keys[i].first.c_str(), index.GetAllocator()), index.GetAllocator());
+				shard.AddMember("Namespace", Value(keys[i].second.c_str(), index.GetAllocator()), index.GetAllocator());
+				shardList.PushBack(shard, index.GetAllocator());
+			}
+			index.AddMember("Shards", shardList, index.GetAllocator());
+			index.AddMember("Symbols", symbols, index.GetAllocator());
+
+			std::ofstream outFile(file);
+			OStreamWrapper wrapper(outFile);
+			Writer<OStreamWrapper> writer(wrapper);
+			index.Accept(writer);
+		}
+
+	private:
+		uint32_t GetShard(const std::pair<std::string, std::string>& key) {
+			auto it = shardIndex.find(key);
+			if (it != shardIndex.end()) {
+				return it->second;
+			}
+			Value shard(kObjectType);
+			shard.AddMember("Functions", Value(kArrayType), allocator);
+			shard.AddMember("Types", Value(kArrayType), allocator);
+			shard.AddMember("TypeDefs", Value(kArrayType), allocator);
+			shard.AddMember("Enums", Value(kArrayType), allocator);
+			shard.AddMember("GlobalVariables", Value(kArrayType), allocator);
+			shards.PushBack(shard, allocator);
+			uint32_t index = shards.Size() - 1;
+			shardIndex[key] = index;
+			keys.push_back(key);
+			return index;
+		}
+
+		Document::AllocatorType& allocator;
+		Value shards;
+		Value symbols;
+		std::map<std::pair<std::string, std::string>, uint32_t> shardIndex;
+		std::vector<std::pair<std::string, std::string>> keys;
+	};
+
+	void ExportModuleAsShards(const char* file, AngelScript::asIScriptModule* module, asIScriptEngine* engine) {
+		Document reflection;
+		ReflectModule(reflection, module, engine);
+		ShardBuilder builder(reflection);
+
+		//ReflectModule keeps the module order, so entry i belongs to the i:th entity of the module
+		Value& funcs = reflection["Functions"];
+		for (uint32_t i = 0; i < funcs.Size(); ++i) {
+			asIScriptFunction* asFunc = module->GetFunctionByIndex(i);
+			builder.Add("Functions", funcs[i], "Function", asFunc->GetScriptSectionName(), asFunc->GetNamespace());
+		}
+		Value& types = reflection["Types"];
+		for (uint32_t i = 0; i < types.Size(); ++i) {
+			asITypeInfo* asType = module->GetObjectTypeByIndex(i);
+			builder.Add("Types", types[i], "Type", GetTypeSection(asType), asType->GetNamespace());
+		}
+		Value& typedefs = reflection["TypeDefs"];
+		for (uint32_t i = 0; i < typedefs.Size(); ++i) {
+			builder.Add("TypeDefs", typedefs[i], "TypeDef", nullptr, module->GetTypedefByIndex(i)->GetNamespace());
+		}
+		Value& enums = reflection["Enums"];
+		for (uint32_t i = 0; i < enums.Size(); ++i) {
+			builder.Add("Enums", enums[i], "Enum", nullptr, module->GetEnumByIndex(i)->GetNamespace());
+		}
+		Value& globalVars = reflection["GlobalVariables"];
+		for (uint32_t i = 0; i < globalVars.Size(); ++i) {
+			builder.Add("GlobalVariables", globalVars[i], "Variable", nullptr, globalVars[i]["Namespace"].GetString());
+		}
+		builder.Write(file);
+	}
+
+	void ReflectModule(Document& output, AngelScript::asIScriptModule* module, asIScriptEngine* engine) {
 		output.SetObject();
 
 		//construct a map of type names declared in module so it can be looked up later
@@ -879,12 +1657,6 @@ namespace AngelScriptExporter {
 			globalVars.PushBack(varVal, output.GetAllocator());
 		}
 		output.AddMember("GlobalVariables", globalVars, output.GetAllocator());
-
-		//write to file
-		std::ofstream outFile(file);
-		OStreamWrapper wrapper(outFile);
-		Writer<OStreamWrapper> writer(wrapper);
-		output.Accept(writer);
 	}
 }
 
@@ -1,4 +1,5 @@
 #pragma once
+#include <rapidjson/fwd.h>
 namespace AngelScript {
 	class asIScriptEngine;
 	class asIScriptModule;
@@ -6,7 +7,20 @@ namespace AngelScript {
 namespace AngelScriptExporter {
 	void ExportEngineAsJSON(const char* file, AngelScript::asIScriptEngine* engine);
 	void ImportEngineFromJson(const char* file, AngelScript::asIScriptEngine* engine);
+	//Compact binary version of the engine interface, registered without building a DOM
+	void ExportEngineAsBinary(const char* file, AngelScript::asIScriptEngine* engine);
+	enum BinaryImportResult {
+		BINARY_IMPORT_NOT_BINARY = 0, //not a binary image, nothing was registered. Try the json importer
+		BINARY_IMPORT_OK,
+		BINARY_IMPORT_CORRUPT, //truncated, corrupt or of another version. An error was written to the engine's message callback
+	};
+	//Only reads the 16 byte header of files that aren't binary images
+	BinaryImportResult ImportEngineFromBinary(const char* file, AngelScript::asIScriptEngine* engine);
 	void ExportModuleAsJSON(const char* file, AngelScript::asIScriptModule* module, AngelScript::asIScriptEngine* engine);
+	//Writes a small symbol index to file and the reflection itself split into one file per script section (or namespace) next to it
+	void ExportModuleAsShards(const char* file, AngelScript::asIScriptModule* module, AngelScript::asIScriptEngine* engine);
+	//Fills output with the same reflection ExportModuleAsJSON writes, for in-process consumers that don't want to go through a file
+	void ReflectModule(rapidjson::Document& output, AngelScript::asIScriptModule* module, AngelScript::asIScriptEngine* engine);
 }
 
 
@@ -0,0 +1,331 @@
+#include "BytecodeReport.h"
+#include <angelscript.h>
+#include <rapidjson/ostreamwrapper.h>
+#include <rapidjson/writer.h>
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace rapidjson;
+using AngelScript::asDWORD;
+using AngelScript::asBYTE;
+using AngelScript::asUINT;
+using AngelScript::asIScriptModule;
+using AngelScript::asIScriptFunction;
+using AngelScript::asITypeInfo;
+using AngelScript::asBCInfo;
+using AngelScript::asBCTypeSize;
+
+namespace AngelScriptExporter {
+	//size in dwords of an instruction, 0 for names that aren't instructions
+	static uint32_t GetInstructionSize(const std::string& name) {
+		static std::map<std::string, uint32_t> sizes;
+		if (sizes.empty()) {
+			for (uint32_t i = 0; i < AngelScript::asBC_MAXBYTECODE; ++i) {
+				sizes[asBCInfo[i].name] = asBCTypeSize[asBCInfo[i].type];
+			}
+		}
+		auto it = sizes.find(name);
+		return it != sizes.end() ? it->second : 0;
+	}
+
+	FunctionBytecode& BytecodeReport::GetFunction(const std::string& declaration) {
+		auto it = lookup.find(declaration);
+		if (it != lookup.end()) {
+			return functions[it->second];
+		}
+		lookup[declaration] = functions.size();
+		functions.emplace_back();
+		functions.back().declaration = declaration;
+		return functions.back();
+	}
+
+	void BytecodeReport::AddFunction(asIScriptFunction* func) {
+		asUINT length = 0;
+		asDWORD* bc = func->GetByteCode(&length);
+		if (!bc) {
+			return;
+		}
+		FunctionBytecode& f = GetFunction(func->GetDeclaration(true, false, false));
+		f.module = func->GetModuleName() ? func->GetModuleName() : "";
+		f.section = func->GetScriptSectionName() ? func->GetScriptSectionName() : "";
+		f.variables = (int32_t)func->GetVarCount();
+		//the engine's bytecode is the final one, it replaces what a dump may have counted
+		f.size = length;
+		f.instructions = 0;
+		f.opcodes.clear();
+		for (asUINT pos = 0; pos < length;) {
+			asBYTE op = *(asBYTE*)&bc[pos];
+			f.opcodes[asBCInfo[op].name]++;
+			f.instructions++;
+			uint32_t size = asBCTypeSize[asBCInfo[op].type];
+			pos += size ? size : 1;
+		}
+	}
+
+	void BytecodeReport::AddModule(asIScriptModule* module) {
+		//methods are reached through several lists, e.g. virtual and real methods or factories and constructors
+		std::set<asIScriptFunction*> added;
+		auto add = [&](asIScriptFunction* func) {
+			if (func && func->GetFuncType() == AngelScript::asFUNC_SCRIPT && func->GetModule() == module && added.insert(func).second) {
+				AddFunction(func);
+			}
+		};
+		for (asUINT i = 0; i < module->GetFunctionCount(); ++i) {
+			add(module->GetFunctionByIndex(i));
+		}
+		for (asUINT i = 0; i < module->GetObjectTypeCount(); ++i) {
+			asITypeInfo* type = module->GetObjectTypeByIndex(i);
+			for (asUINT k = 0; k < type->GetMethodCount(); ++k) {
+				add(type->GetMethodByIndex(k, false));
+			}
+			for (asUINT k = 0; k < type->GetBehaviourCount(); ++k) {
+				add(type->GetBehaviourByIndex(k, nullptr));
+			}
+			for (asUINT k = 0; k < type->GetFactoryCount(); ++k) {
+				add(type->GetFactoryByIndex(k));
+			}
+		}
+	}
+
+	static bool ReadLines(const char* file, std::vector<std::string>& lines) {
+		std::ifstream in(file);
+		if (!in) {
+			return false;
+		}
+		std::string line;
+		while (std::getline(in, line)) {
+			if (!line.empty() && line.back() == '\r') {
+				line.pop_back();
+			}
+			lines.push_back(line);
+		}
+		return true;
+	}
+
+	static std::string Trim(const std::string& str) {
+		size_t first = str.find_first_not_of(" \t");
+		if (first == std::string::npos) {
+			return "";
+		}
+		return str.substr(first, str.find_last_not_of(" \t") - first + 1);
+	}
+
+	bool BytecodeReport::AddDump(const char* file) {
+		std::vector<std::string> lines;
+		if (!ReadLines(file, lines) || lines.empty() || lines[0].empty()) {
+			return false;
+		}
+		FunctionBytecode& f = GetFunction(lines[0]);
+		bool counted = f.instructions != 0;
+		bool inVariables = false;
+		int32_t variables = 0;
+		f.temps.clear();
+		f.deadCode.clear();
+		for (size_t i = 1; i < lines.size(); ++i) {
+			const char* line = lines[i].c_str();
+			if (strncmp(line, "Temps:", 6) == 0) {
+				for (const char* p = line + 6; *p;) {
+					char* end;
+					long temp = strtol(p, &end, 10);
+					if (end == p) {
+						++p;
+						continue;
+					}
+					f.temps.push_back((int)temp);
+					p = end;
+				}
+				continue;
+			}
+			if (strncmp(line, "Variables:", 10) == 0) {
+				inVariables = true;
+				continue;
+			}
+			if (inVariables) {
+				if (Trim(lines[i]).empty()) {
+					inVariables = false;
+				} else {
+					variables++;
+				}
+				continue;
+			}
+			//instructions are written as "%5d %3d %c    %-8s", position, stack size, '*' if reachable and the name.
+			//Labels, line numbers and pseudo instructions like VarDecl don't have the same layout.
+			char* end;
+			long pos = strtol(line, &end, 10);
+			if (end == line || *end != ' ') {
+				continue;
+			}
+			const char* p = end;
+			strtol(p, &end, 10);
+			if (end == p || end[0] != ' ' || !end[1] || end[2] != ' ') {
+				continue;
+			}
+			bool reachable = end[1] == '*';
+			std::string name = Trim(end + 2);
+			name = name.substr(0, name.find(' '));
+			uint32_t size = GetInstructionSize(name);
+			if (size == 0) {
+				continue;
+			}
+			if (!reachable) {
+				if (!f.deadCode.empty() && f.deadCode.back().second + 1 >= (uint32_t)pos) {
+					f.deadCode.back().second = (uint32_t)pos + size - 1;
+				} else {
+					f.deadCode.push_back({ (uint32_t)pos, (uint32_t)pos + size - 1 });
+				}
+			}
+			if (!counted) {
+				f.opcodes[name]++;
+				f.instructions++;
+				f.size = std::max(f.size, (uint32_t)pos + size);
+			}
+		}
+		if (f.variables < 0) {
+			f.variables = variables;
+		}
+		return true;
+	}
+
+	bool BytecodeReport::AddStats(const char* file) {
+		std::vector<std::string> lines;
+		if (!ReadLines(file, lines)) {
+			return false;
+		}
+		enum { NONE, TOTAL, NEVER } section = NONE;
+		for (auto& line : lines) {
+			std::string trimmed = Trim(line);
+			if (trimmed == "Total count") {
+				section = TOTAL;
+			} else if (trimmed == "Never executed") {
+				section = NEVER;
+			} else if (trimmed == "Sequences") {
+				section = NONE;
+			} else if (trimmed.empty()) {
+				continue;
+			} else if (section == TOTAL) {
+				//"name : count"
+				size_t colon = trimmed.find(':');
+				if (colon != std::string::npos) {
+					executed[Trim(trimmed.substr(0, colon))] += atof(trimmed.c_str() + colon + 1);
+				}
+			} else if (section == NEVER) {
+				if (std::find(neverExecuted.begin(), neverExecuted.end(), trimmed) == neverExecuted.end()) {
+					neverExecuted.push_back(trimmed);
+				}
+			}
+		}
+		return true;
+	}
+
+	template<typename WRITER>
+	static void WriteOpcodes(WRITER& writer, const std::map<std::string, uint32_t>& opcodes) {
+		//most used first
+		std::vector<std::pair<uint32_t, const std::string*>> order;
+		for (auto& op : opcodes) {
+			order.push_back({ op.second, &op.first });
+		}
+		std::stable_sort(order.begin(), order.end(), [](const std::pair<uint32_t, const std::string*>& a, const std::pair<uint32_t, const std::string*>& b) {
+			return a.first > b.first;
+		});
+		writer.StartObject();
+		for (auto& op : order) {
+			writer.Key(op.second->c_str());
+			writer.Uint(op.first);
+		}
+		writer.EndObject();
+	}
+
+	bool BytecodeReport::Write(const char* file) const {
+		std::ofstream outFile(file);
+		if (!outFile) {
+			return false;
+		}
+		std::vector<const FunctionBytecode*> order;
+		std::map<std::string, uint32_t> totals;
+		uint32_t totalSize = 0;
+		for (auto& f : functions) {
+			order.push_back(&f);
+			totalSize += f.size;
+			for (auto& op : f.opcodes) {
+				totals[op.first] += op.second;
+			}
+		}
+		std::stable_sort(order.begin(), order.end(), [](const FunctionBytecode* a, const FunctionBytecode* b) {
+			return a->size > b->size;
+		});
+
+		OStreamWrapper wrapper(outFile);
+		Writer<OStreamWrapper> writer(wrapper);
+		writer.StartObject();
+		writer.Key("TotalSize");
+		writer.Uint(totalSize);
+		writer.Key("Opcodes");
+		WriteOpcodes(writer, totals);
+		writer.Key("Functions");
+		writer.StartArray();
+		for (auto f : order) {
+			writer.StartObject();
+			writer.Key("Declaration");
+			writer.String(f->declaration.c_str());
+			if (!f->module.empty()) {
+				writer.Key("Module");
+				writer.String(f->module.c_str());
+			}
+			if (!f->section.empty()) {
+				writer.Key("Section");
+				writer.String(f->section.c_str());
+			}
+			writer.Key("Size");
+			writer.Uint(f->size);
+			writer.Key("Instructions");
+			writer.Uint(f->instructions);
+			if (f->variables >= 0) {
+				writer.Key("Variables");
+				writer.Int(f->variables);
+			}
+			writer.Key("Temps");
+			writer.StartArray();
+			for (int temp : f->temps) {
+				writer.Int(temp);
+			}
+			writer.EndArray();
+			writer.Key("Opcodes");
+			WriteOpcodes(writer, f->opcodes);
+			writer.Key("DeadCode");
+			writer.StartArray();
+			for (auto& range : f->deadCode) {
+				writer.StartArray();
+				writer.Uint(range.first);
+				writer.Uint(range.second);
+				writer.EndArray();
+			}
+			writer.EndArray();
+			writer.EndObject();
+		}
+		writer.EndArray();
+		//runtime counts, only available if stats.txt was added
+		if (!executed.empty() || !neverExecuted.empty()) {
+			writer.Key("Executed");
+			writer.StartObject();
+			for (auto& op : executed) {
+				writer.Key(op.first.c_str());
+				writer.Double(op.second);
+			}
+			writer.EndObject();
+			//opcodes the scripts use that never ran, e.g. code behind a condition that never held
+			writer.Key("NeverExecuted");
+			writer.StartArray();
+			for (auto& op : neverExecuted) {
+				if (totals.empty() || totals.count(op)) {
+					writer.String(op.c_str());
+				}
+			}
+			writer.EndArray();
+		}
+		writer.EndObject();
+		return true;
+	}
+}
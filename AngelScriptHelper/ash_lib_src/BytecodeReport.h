@@ -0,0 +1,48 @@
+#pragma once
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+namespace AngelScript {
+	class asIScriptFunction;
+	class asIScriptModule;
+}
+namespace AngelScriptExporter {
+	struct FunctionBytecode {
+		std::string declaration; //same format as the first line of the AS_DEBUG dumps
+		std::string module;
+		std::string section;
+		uint32_t size = 0; //in dwords, positions in the dumps are in dwords as well
+		uint32_t instructions = 0;
+		int32_t variables = -1; //-1 = unknown
+		std::vector<int> temps; //stack offsets of the temporaries, only known from the dumps
+		std::map<std::string, uint32_t> opcodes;
+		std::vector<std::pair<uint32_t, uint32_t>> deadCode; //[first, last] positions the compiler marked as unreachable
+	};
+
+	/*
+	Bytecode statistics of script functions, read from a compiled module and/or from the dumps an AS_DEBUG
+	build of the engine writes: one __<function>.txt per function and stats.txt with the executed opcodes.
+	Functions from both sources are merged on their declaration.
+	*/
+	class BytecodeReport {
+	public:
+		void AddModule(AngelScript::asIScriptModule* module);
+		void AddFunction(AngelScript::asIScriptFunction* func);
+		//Per function dump, returns false if the file can't be read
+		bool AddDump(const char* file);
+		//"Total count" and "Never executed" of stats.txt
+		bool AddStats(const char* file);
+
+		//Functions are sorted on size, largest first
+		bool Write(const char* file) const;
+
+	private:
+		FunctionBytecode& GetFunction(const std::string& declaration);
+
+		std::vector<FunctionBytecode> functions;
+		std::map<std::string, size_t> lookup;
+		std::map<std::string, double> executed;
+		std::vector<std::string> neverExecuted;
+	};
+}
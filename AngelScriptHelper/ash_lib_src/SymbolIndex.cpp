@@ -0,0 +1,254 @@
+#include "SymbolIndex.h"
+#include <angelscript.h>
+#include <rapidjson/document.h>
+#include <rapidjson/filereadstream.h>
+#include <rapidjson/ostreamwrapper.h>
+#include <rapidjson/writer.h>
+#include <algorithm>
+#include <fstream>
+#include <stdio.h>
+#include <string.h>
+
+using namespace rapidjson;
+using AngelScript::asIScriptEngine;
+using AngelScript::asIScriptModule;
+using AngelScript::asIScriptFunction;
+using AngelScript::asITypeInfo;
+
+namespace AngelScriptExporter {
+	static const char* symbolKindNames[] = { "Function", "Type", "Enum", "EnumValue", "Funcdef", "TypeDef", "Variable" };
+
+	const char* GetSymbolKindName(SymbolKind kind) {
+		for (uint32_t i = 0; i < sizeof(symbolKindNames) / sizeof(symbolKindNames[0]); ++i) {
+			if (kind == (1u << i)) {
+				return symbolKindNames[i];
+			}
+		}
+		return "";
+	}
+
+	SymbolKind GetSymbolKindByName(const char* name) {
+		for (uint32_t i = 0; i < sizeof(symbolKindNames) / sizeof(symbolKindNames[0]); ++i) {
+			if (strcmp(name, symbolKindNames[i]) == 0) {
+				return (SymbolKind)(1u << i);
+			}
+		}
+		return (SymbolKind)0;
+	}
+
+	static void ToLower(const char* str, std::string& out) {
+		out.clear();
+		for (; *str; ++str) {
+			char c = *str;
+			out += (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+		}
+	}
+
+	static bool SymbolLess(const Symbol& a, const Symbol& b) {
+		return a.key < b.key;
+	}
+
+	void SymbolIndex::Add(const char* name, const char* nameSpace, const char* declaration, SymbolKind kind) {
+		if (!name || !*name) {
+			return;
+		}
+		Symbol s;
+		ToLower(name, s.key);
+		s.name = name;
+		s.nameSpace = nameSpace ? nameSpace : "";
+		s.declaration = declaration ? declaration : "";
+		s.kind = kind;
+		if (!symbols.empty() && s.key < symbols.back().key) {
+			sorted = false;
+		}
+		symbols.push_back(std::move(s));
+		if (kind != SYMBOL_ENUM_VALUE && nameSpace && *nameSpace) {
+			AddNamespace(nameSpace);
+		}
+	}
+
+	void SymbolIndex::AddNamespace(const char* nameSpace) {
+		Symbol n;
+		const char* end = strstr(nameSpace, "::");
+		n.name = end ? std::string(nameSpace, end) : std::string(nameSpace);
+		ToLower(n.name.c_str(), n.key);
+		n.kind = (SymbolKind)0;
+		auto it = std::lower_bound(namespaces.begin(), namespaces.end(), n, SymbolLess);
+		for (auto same = it; same != namespaces.end() && same->key == n.key; ++same) {
+			if (same->name == n.name) {
+				return;
+			}
+		}
+		namespaces.insert(it, std::move(n));
+	}
+
+	void SymbolIndex::Sort() {
+		if (!sorted) {
+			std::stable_sort(symbols.begin(), symbols.end(), SymbolLess);
+			sorted = true;
+		}
+	}
+
+	void SymbolIndex::Clear() {
+		symbols.clear();
+		namespaces.clear();
+		sorted = true;
+	}
+
+	//enum values are reached through the enum, Enum::Value or ns::Enum::Value
+	static void AddEnum(SymbolIndex& index, asITypeInfo* type) {
+		std::string scope = type->GetNamespace() ? type->GetNamespace() : "";
+		if (!scope.empty()) {
+			scope += "::";
+		}
+		scope += type->GetName();
+		index.Add(type->GetName(), type->GetNamespace(), scope.c_str(), SYMBOL_ENUM);
+		for (uint32_t k = 0; k < type->GetEnumValueCount(); ++k) {
+			int value;
+			const char* name = type->GetEnumValueByIndex(k, &value);
+			std::string declaration = scope + "::" + (name ? name : "") + " = " + std::to_string(value);
+			index.Add(name, scope.c_str(), declaration.c_str(), SYMBOL_ENUM_VALUE);
+		}
+	}
+
+	void SymbolIndex::AddEngine(asIScriptEngine* engine) {
+		for (uint32_t i = 0; i < engine->GetGlobalFunctionCount(); ++i) {
+			asIScriptFunction* func = engine->GetGlobalFunctionByIndex(i);
+			Add(func->GetName(), func->GetNamespace(), func->GetDeclaration(true, false, true), SYMBOL_FUNCTION);
+		}
+		for (uint32_t i = 0; i < engine->GetObjectTypeCount(); ++i) {
+			asITypeInfo* type = engine->GetObjectTypeByIndex(i);
+			Add(type->GetName(), type->GetNamespace(), engine->GetTypeDeclaration(type->GetTypeId(), true), SYMBOL_TYPE);
+		}
+		for (uint32_t i = 0; i < engine->GetEnumCount(); ++i) {
+			AddEnum(*this, engine->GetEnumByIndex(i));
+		}
+		for (uint32_t i = 0; i < engine->GetFuncdefCount(); ++i) {
+			asITypeInfo* funcdef = engine->GetFuncdefByIndex(i);
+			asIScriptFunction* signature = funcdef->GetFuncdefSignature();
+			Add(funcdef->GetName(), funcdef->GetNamespace(), signature ? signature->GetDeclaration(true, false, true) : "", SYMBOL_FUNCDEF);
+		}
+		for (uint32_t i = 0; i < engine->GetTypedefCount(); ++i) {
+			asITypeInfo* type = engine->GetTypedefByIndex(i);
+			Add(type->GetName(), type->GetNamespace(), engine->GetTypeDeclaration(type->GetTypedefTypeId(), true), SYMBOL_TYPEDEF);
+		}
+		for (uint32_t i = 0; i < engine->GetGlobalPropertyCount(); ++i) {
+			const char* name;
+			const char* nameSpace;
+			int typeId;
+			bool isConst;
+			engine->GetGlobalPropertyByIndex(i, &name, &nameSpace, &typeId, &isConst);
+			std::string declaration = std::string(isConst ? "const " : "") + engine->GetTypeDeclaration(typeId, true) + " " + (name ? name : "");
+			Add(name, nameSpace, declaration.c_str(), SYMBOL_VARIABLE);
+		}
+		Sort();
+	}
+
+	void SymbolIndex::AddModule(asIScriptModule* module) {
+		asIScriptEngine* engine = module->GetEngine();
+		for (uint32_t i = 0; i < module->GetFunctionCount(); ++i) {
+			asIScriptFunction* func = module->GetFunctionByIndex(i);
+			Add(func->GetName(), func->GetNamespace(), func->GetDeclaration(true, false, true), SYMBOL_FUNCTION);
+		}
+		for (uint32_t i = 0; i < module->GetObjectTypeCount(); ++i) {
+			asITypeInfo* type = module->GetObjectTypeByIndex(i);
+			Add(type->GetName(), type->GetNamespace(), engine->GetTypeDeclaration(type->GetTypeId(), true), SYMBOL_TYPE);
+		}
+		for (uint32_t i = 0; i < module->GetEnumCount(); ++i) {
+			AddEnum(*this, module->GetEnumByIndex(i));
+		}
+		for (uint32_t i = 0; i < module->GetTypedefCount(); ++i) {
+			asITypeInfo* type = module->GetTypedefByIndex(i);
+			Add(type->GetName(), type->GetNamespace(), engine->GetTypeDeclaration(type->GetTypedefTypeId(), true), SYMBOL_TYPEDEF);
+		}
+		for (uint32_t i = 0; i < module->GetGlobalVarCount(); ++i) {
+			const char* name;
+			const char* nameSpace;
+			module->GetGlobalVar(i, &name, &nameSpace);
+			Add(name, nameSpace, module->GetGlobalVarDeclaration(i, true), SYMBOL_VARIABLE);
+		}
+		Sort();
+	}
+
+	size_t SymbolIndex::Find(const char* prefix, std::vector<const Symbol*>& results, uint32_t kinds, const char* nameSpace, size_t maxResults) const {
+		Symbol key;
+		ToLower(prefix, key.key);
+		size_t found = 0;
+		for (auto it = std::lower_bound(symbols.begin(), symbols.end(), key, SymbolLess); it != symbols.end(); ++it) {
+			if (it->key.compare(0, key.key.size(), key.key) != 0) {
+				break;
+			}
+			if (!(it->kind & kinds) || (nameSpace && it->nameSpace != nameSpace)) {
+				continue;
+			}
+			results.push_back(&*it);
+			if (++found == maxResults) {
+				break;
+			}
+		}
+		return found;
+	}
+
+	size_t SymbolIndex::FindNamespaces(const char* prefix, std::vector<const Symbol*>& results, size_t maxResults) const {
+		Symbol key;
+		ToLower(prefix, key.key);
+		size_t found = 0;
+		for (auto it = std::lower_bound(namespaces.begin(), namespaces.end(), key, SymbolLess); it != namespaces.end(); ++it) {
+			if (it->key.compare(0, key.key.size(), key.key) != 0) {
+				break;
+			}
+			results.push_back(&*it);
+			if (++found == maxResults) {
+				break;
+			}
+		}
+		return found;
+	}
+
+	bool SymbolIndex::Write(const char* file) const {
+		std::ofstream outFile(file);
+		if (!outFile) {
+			return false;
+		}
+		OStreamWrapper wrapper(outFile);
+		Writer<OStreamWrapper> writer(wrapper);
+		writer.StartObject();
+		writer.Key("Symbols");
+		writer.StartArray();
+		for (auto& s : symbols) {
+			writer.StartArray();
+			writer.String(s.name.c_str(), (SizeType)s.name.size());
+			writer.String(s.nameSpace.c_str(), (SizeType)s.nameSpace.size());
+			writer.String(GetSymbolKindName(s.kind));
+			writer.String(s.declaration.c_str(), (SizeType)s.declaration.size());
+			writer.EndArray();
+		}
+		writer.EndArray();
+		writer.EndObject();
+		return true;
+	}
+
+	bool SymbolIndex::Read(const char* file) {
+		FILE* fin = fopen(file, "rb");
+		if (!fin) {
+			return false;
+		}
+		char buffer[65536];
+		FileReadStream stream(fin, buffer, sizeof(buffer));
+		Document document;
+		document.ParseStream(stream);
+		fclose(fin);
+		if (document.HasParseError() || !document.IsObject() || !document.HasMember("Symbols") || !document["Symbols"].IsArray()) {
+			return false;
+		}
+		symbols.reserve(symbols.size() + document["Symbols"].Size());
+		for (auto& s : document["Symbols"].GetArray()) {
+			if (!s.IsArray() || s.Size() < 4 || !s[0].IsString() || !s[1].IsString() || !s[2].IsString() || !s[3].IsString()) {
+				continue;
+			}
+			Add(s[0].GetString(), s[1].GetString(), s[3].GetString(), GetSymbolKindByName(s[2].GetString()));
+		}
+		Sort();
+		return true;
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+namespace AngelScript {
+	class asIScriptEngine;
+	class asIScriptModule;
+}
+namespace AngelScriptExporter {
+	enum SymbolKind : uint32_t {
+		SYMBOL_FUNCTION = 0x1,
+		SYMBOL_TYPE = 0x2,
+		SYMBOL_ENUM = 0x4,
+		SYMBOL_ENUM_VALUE = 0x8,
+		SYMBOL_FUNCDEF = 0x10,
+		SYMBOL_TYPEDEF = 0x20,
+		SYMBOL_VARIABLE = 0x40,
+		SYMBOL_ALL = 0x7F
+	};
+
+	const char* GetSymbolKindName(SymbolKind kind);
+	//Returns 0 for unknown names
+	SymbolKind GetSymbolKindByName(const char* name);
+
+	struct Symbol {
+		std::string key; //lower case name, the index is sorted on it
+		std::string name;
+		std::string nameSpace; //enum values use the enum as their namespace
+		std::string declaration;
+		SymbolKind kind;
+	};
+
+	/*
+	Global symbols of an engine interface and/or a module in a table sorted on their lower case name, so
+	completions are a binary search for the prefix followed by a scan over the matches.
+	Type members are not part of the index, they are looked up through their type.
+	*/
+	class SymbolIndex {
+	public:
+		void AddEngine(AngelScript::asIScriptEngine* engine);
+		void AddModule(AngelScript::asIScriptModule* module);
+		void Add(const char* name, const char* nameSpace, const char* declaration, SymbolKind kind);
+		//Has to be called after adding symbols, AddEngine, AddModule and Read sort the index themselves
+		void Sort();
+		void Clear();
+		size_t Size() const { return symbols.size(); }
+
+		//Appends up to maxResults (0 = no limit) symbols whose name starts with prefix, ignoring case, in name order.
+		//nameSpace limits the results to a single namespace, nullptr matches all of them.
+		size_t Find(const char* prefix, std::vector<const Symbol*>& results, uint32_t kinds = SYMBOL_ALL, const char* nameSpace = nullptr, size_t maxResults = 0) const;
+		//Same as Find for the top level namespaces of the symbols, which are matched on their own name.
+		//Only name and key are set in the results.
+		size_t FindNamespaces(const char* prefix, std::vector<const Symbol*>& results, size_t maxResults = 0) const;
+
+		//Compact json, one array per symbol: [ name, namespace, kind, declaration ]
+		bool Write(const char* file) const;
+		bool Read(const char* file);
+
+	private:
+		void AddNamespace(const char* nameSpace);
+
+		std::vector<Symbol> symbols;
+		//sorted on the key, the namespaces of enum values are left out as they are enums
+		std::vector<Symbol> namespaces;
+		bool sorted = true;
+	};
+}
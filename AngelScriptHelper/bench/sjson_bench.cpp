@@ -0,0 +1,191 @@
+#include "dynamic_config_value.h"
+#include "parse_simplified_json.h"
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace stingray;
+
+/*
+Measures the SJSON parser on generated corpora and, optionally, on real files.
+premake builds it twice, SjsonBench with the SIMD scanners and SjsonBenchScalar with SJSON_NO_SIMD,
+run both on the same machine to compare them.
+	SjsonBench [-s <MB per corpus>] [-r <runs>] [-o <dir>] [files...]
+-o writes the generated corpora to dir, so they can be fed to other builds or tools.
+Every corpus is parsed -r times, the fastest run is reported.
+*/
+
+struct Corpus {
+	std::string name;
+	std::string text;
+};
+
+//Engine settings: nested objects, short strings and numbers, a comment here and there
+static void GenerateSettings(size_t size, std::string& out) {
+	for (int i = 0; out.size() < size; ++i) {
+		std::string n = std::to_string(i);
+		out += "unit_" + n + " = {\n"
+			"\tname = \"unit_name_" + n + "\"\n"
+			"\tposition = [1.5, 2.25, -3]\n"
+			"\tenabled = true\n"
+			"\t// tuning\n"
+			"\tmaterials = {\n"
+			"\t\tdiffuse = \"textures/characters/hero/diffuse_" + n + "\"\n"
+			"\t\tnormal = \"textures/characters/hero/normal_" + n + "\"\n"
+			"\t}\n"
+			"}\n";
+	}
+}
+
+//Localization style files: long strings with the odd escape, block comments
+static void GenerateText(size_t size, std::string& out) {
+	for (int i = 0; out.size() < size; ++i) {
+		out += "/* Localized text block, translated strings follow and may contain \\\"escapes\\\" */\n"
+			"string_" + std::to_string(i) + " = \"The quick brown fox jumps over the lazy dog while the cat watches from the window sill, " + std::to_string(i) + "\"\n";
+	}
+}
+
+//Deep indentation and small arrays, most of the bytes are whitespace
+static void GenerateIndented(size_t size, std::string& out) {
+	std::string indent(80, '\t');
+	for (int i = 0; out.size() < size; ++i) {
+		out += indent + "key_" + std::to_string(i) + " = [ 1, 2, 3, 4, 5, 6, 7, 8 ]\n";
+	}
+}
+
+//Long strings, comments and blank runs, the scanners' best case
+static void GenerateScan(size_t size, std::string& out) {
+	std::string text(4000, 'x');
+	std::string comment(4000, '-');
+	std::string blanks(4000, ' ');
+	for (int i = 0; out.size() < size; ++i) {
+		out += "s" + std::to_string(i) + " = \"" + text + "\"\n/*" + comment + "*/" + blanks + "\n";
+	}
+}
+
+static const char* GetScannerName() {
+#if defined(SJSON_NO_SIMD)
+	return "scalar";
+#elif defined(__AVX2__)
+	return "AVX2";
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	return "SSE2";
+#else
+	return "scalar";
+#endif
+}
+
+static double Seconds(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//Returns the fastest run in seconds, or a negative value if the corpus doesn't parse
+static double TimeParse(const std::string& text, int runs) {
+	double best = -1;
+	for (int r = 0; r < runs; ++r) {
+		DynamicConfigValue value;
+		sjson::ParseError error;
+		auto start = std::chrono::steady_clock::now();
+		const char* message = sjson::parse(Buffer(text.c_str(), (unsigned)text.size()), value, error);
+		double t = Seconds(start);
+		if (message) {
+			fprintf(stderr, "%s\n", message);
+			return -1;
+		}
+		if (best < 0 || t < best) {
+			best = t;
+		}
+	}
+	return best;
+}
+
+//parse_in_place writes into its input, every run gets a fresh copy that isn't timed
+static double TimeParseInPlace(const std::string& text, int runs) {
+	double best = -1;
+	std::vector<char> buffer;
+	for (int r = 0; r < runs; ++r) {
+		buffer.assign(text.begin(), text.end());
+		buffer.push_back(0);
+		DynamicConfigValue value;
+		sjson::ParseError error;
+		auto start = std::chrono::steady_clock::now();
+		const char* message = sjson::parse_in_place(Buffer(buffer.data(), (unsigned)text.size()), value, error, *ConfigArena::create(text.size() / 2));
+		double t = Seconds(start);
+		if (message) {
+			fprintf(stderr, "%s\n", message);
+			return -1;
+		}
+		if (best < 0 || t < best) {
+			best = t;
+		}
+	}
+	return best;
+}
+
+int main(int argc, char** argv) {
+	size_t size = 64;
+	int runs = 5;
+	std::string outputDir;
+	std::vector<std::string> files;
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+			size = (size_t)atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+			runs = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+			outputDir = argv[++i];
+		} else {
+			files.push_back(argv[i]);
+		}
+	}
+	if (runs < 1) {
+		runs = 1;
+	}
+
+	std::vector<Corpus> corpora;
+	void (*generators[])(size_t, std::string&) = { GenerateSettings, GenerateText, GenerateIndented, GenerateScan };
+	const char* names[] = { "settings", "text", "indented", "scan" };
+	for (int k = 0; k < 4; ++k) {
+		Corpus corpus;
+		corpus.name = names[k];
+		generators[k](size << 20, corpus.text);
+		if (!outputDir.empty()) {
+			std::ofstream out(outputDir + "/" + corpus.name + ".sjson", std::ios::binary);
+			out.write(corpus.text.data(), corpus.text.size());
+		}
+		corpora.push_back(std::move(corpus));
+	}
+	for (auto& file : files) {
+		std::ifstream in(file, std::ios::binary);
+		if (!in) {
+			fprintf(stderr, "Could not open %s\n", file.c_str());
+			return 1;
+		}
+		std::stringstream content;
+		content << in.rdbuf();
+		Corpus corpus;
+		corpus.name = file;
+		corpus.text = content.str();
+		corpora.push_back(std::move(corpus));
+	}
+
+	printf("scanners: %s, best of %d runs\n", GetScannerName(), runs);
+	printf("%-24s %10s %12s %14s\n", "corpus", "MB", "parse MB/s", "in place MB/s");
+	for (auto& corpus : corpora) {
+		double mb = corpus.text.size() / 1e6;
+		double parse = TimeParse(corpus.text, runs);
+		double inPlace = TimeParseInPlace(corpus.text, runs);
+		if (parse < 0 || inPlace < 0) {
+			fprintf(stderr, "%s doesn't parse\n", corpus.name.c_str());
+			return 1;
+		}
+		printf("%-24s %10.1f %12.0f %14.0f\n", corpus.name.c_str(), mb, mb / parse, mb / inPlace);
+	}
+	return 0;
+}
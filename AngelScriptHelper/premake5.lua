@@ -48,6 +48,28 @@ solution "Ash"
 		location ( location_path )
 		language "C++"
 		kind "StaticLib"
-		files { "ash_lib_src/AngelScriptExporter.h", "ash_lib_src/AngelScriptExporter.cpp"}
+		files { "ash_lib_src/AngelScriptExporter.h", "ash_lib_src/AngelScriptExporter.cpp", "ash_lib_src/SymbolIndex.h", "ash_lib_src/SymbolIndex.cpp", "ash_lib_src/BytecodeReport.h", "ash_lib_src/BytecodeReport.cpp"}
         includedirs { "include" }
         staticruntime "On"
+
+    -- Parser benchmark, built with and without the SIMD scanners to compare them on the same corpora
+    project "SjsonBench"
+        targetname "SjsonBench"
+		debugdir ""
+		location ( location_path )
+		language "C++"
+		kind "ConsoleApp"
+		files { "bench/sjson_bench.cpp", "src/stingray/parse_simplified_json.*", "src/stingray/dynamic_config_value.*" }
+        includedirs { "src/stingray" }
+        staticruntime "On"
+
+    project "SjsonBenchScalar"
+        targetname "SjsonBenchScalar"
+        defines { "SJSON_NO_SIMD" }
+		debugdir ""
+		location ( location_path )
+		language "C++"
+		kind "ConsoleApp"
+		files { "bench/sjson_bench.cpp", "src/stingray/parse_simplified_json.*", "src/stingray/dynamic_config_value.*" }
+        includedirs { "src/stingray" }
+        staticruntime "On"
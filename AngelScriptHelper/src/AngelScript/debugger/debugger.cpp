@@ -12,11 +12,17 @@ CDebugger::CDebugger()
 {
 	m_action = CONTINUE;
 	m_lastFunction = 0;
+	m_lastFunctionBreakPoints = 0;
 	m_engine = 0;
+	m_lineCallbackInstalled = false;
+	m_breakRequested = false;
 }
 
 CDebugger::~CDebugger()
 {
+	while( m_contexts.size() )
+		Detach(m_contexts.back());
+	ResetBreakPointCache();
 	SetEngine(0);
 }
 
@@ -176,6 +182,13 @@ void CDebugger::LineCallback(asIScriptContext *ctx)
 	if( ctx->GetState() != asEXECUTION_ACTIVE )
 		return;
 
+	// A requested break behaves like a step into from wherever the script is
+	if( m_breakRequested )
+	{
+		m_breakRequested = false;
+		m_action = STEP_INTO;
+	}
+
 	if( m_action == CONTINUE )
 	{
 		if( !CheckBreakPoint(ctx) )
@@ -212,6 +225,66 @@ void CDebugger::LineCallback(asIScriptContext *ctx)
 	Output(s.str());
 
 	TakeCommands(ctx);
+
+	// The commands may have removed the last reason to keep the line callback
+	UpdateLineCallbacks();
+}
+
+void CDebugger::Attach(asIScriptContext *ctx)
+{
+	if( ctx == 0 )
+		return;
+	for( size_t n = 0; n < m_contexts.size(); n++ )
+		if( m_contexts[n] == ctx )
+			return;
+
+	ctx->AddRef();
+	m_contexts.push_back(ctx);
+	if( m_lineCallbackInstalled )
+		ctx->SetLineCallback(asMETHOD(CDebugger, LineCallback), this, asCALL_THISCALL);
+	UpdateLineCallbacks();
+}
+
+void CDebugger::Detach(asIScriptContext *ctx)
+{
+	for( size_t n = 0; n < m_contexts.size(); n++ )
+	{
+		if( m_contexts[n] == ctx )
+		{
+			if( m_lineCallbackInstalled )
+				ctx->ClearLineCallback();
+			ctx->Release();
+			m_contexts.erase(m_contexts.begin()+n);
+			return;
+		}
+	}
+}
+
+void CDebugger::RequestBreak()
+{
+	m_breakRequested = true;
+	UpdateLineCallbacks();
+}
+
+bool CDebugger::NeedsLineCallback() const
+{
+	return m_breakRequested || m_action != CONTINUE || !m_breakPoints.empty();
+}
+
+void CDebugger::UpdateLineCallbacks()
+{
+	bool needed = NeedsLineCallback();
+	if( needed == m_lineCallbackInstalled )
+		return;
+
+	m_lineCallbackInstalled = needed;
+	for( size_t n = 0; n < m_contexts.size(); n++ )
+	{
+		if( needed )
+			m_contexts[n]->SetLineCallback(asMETHOD(CDebugger, LineCallback), this, asCALL_THISCALL);
+		else
+			m_contexts[n]->ClearLineCallback();
+	}
 }
 
 bool CDebugger::CheckBreakPoint(asIScriptContext *ctx)
@@ -219,83 +292,119 @@ bool CDebugger::CheckBreakPoint(asIScriptContext *ctx)
 	if( ctx == 0 )
 		return false;
 
-	// TODO: Should cache the break points in a function by checking which possible break points
-	//       can be hit when entering a function. If there are no break points in the current function
-	//       then there is no need to check every line.
+	// Nothing to check while there are no break points
+	if( m_breakPoints.empty() )
+		return false;
+
+	// Did we move into a new function?
+	asIScriptFunction *func = ctx->GetFunction();
+	if( m_lastFunction != func )
+	{
+		m_lastFunction = func;
+		m_lastFunctionBreakPoints = ResolveBreakPoints(func, ctx);
+	}
+
+	// No break points in this function, so there is no need to check the line
+	if( m_lastFunctionBreakPoints == 0 || m_lastFunctionBreakPoints->empty() )
+		return false;
+
+	// Determine if there is a breakpoint at the current line
+	const char *file = 0;
+	int lineNbr = ctx->GetLineNumber(0, 0, &file);
+	for( size_t n = 0; n < m_lastFunctionBreakPoints->size(); n++ )
+	{
+		asUINT b = (*m_lastFunctionBreakPoints)[n];
+		if( m_breakPoints[b].lineNbr == lineNbr )
+		{
+			stringstream s;
+			s << "Reached break point " << b << " in file '" << m_breakPoints[b].name << "' at line " << lineNbr << endl;
+			Output(s.str());
+			return true;
+		}
+	}
+
+	return false;
+}
 
-	const char *tmp = 0;
-	int lineNbr = ctx->GetLineNumber(0, 0, &tmp);
+const vector<asUINT> *CDebugger::ResolveBreakPoints(asIScriptFunction *func, asIScriptContext *ctx)
+{
+	if( func == 0 )
+		return 0;
+
+	map<asIScriptFunction*, vector<asUINT> >::iterator it = m_functionBreakPoints.find(func);
+	if( it != m_functionBreakPoints.end() )
+		return &it->second;
+
+	// Hold on to the function so the address can't be reused by another function while it is in the cache
+	func->AddRef();
+	vector<asUINT> &lines = m_functionBreakPoints[func];
 
 	// Consider just filename, not the full path
-	string file = tmp ? tmp : "";
+	const char *section = func->GetScriptSectionName();
+	string file = section ? section : "";
 	size_t r = file.find_last_of("\\/");
 	if( r != string::npos )
 		file = file.substr(r+1);
 
-	// Did we move into a new function?
-	asIScriptFunction *func = ctx->GetFunction();
-	if( m_lastFunction != func )
+	for( size_t n = 0; n < m_breakPoints.size(); n++ )
 	{
-		// Check if any breakpoints need adjusting
-		for( size_t n = 0; n < m_breakPoints.size(); n++ )
+		// We need to check for a breakpoint at entering the function
+		if( m_breakPoints[n].func )
 		{
-			// We need to check for a breakpoint at entering the function
-			if( m_breakPoints[n].func )
+			if( m_breakPoints[n].name == func->GetName() )
 			{
-				if( m_breakPoints[n].name == func->GetName() )
-				{
-					stringstream s;
-					s << "Entering function '" << m_breakPoints[n].name << "'. Transforming it into break point" << endl;
-					Output(s.str());
-
-					// Transform the function breakpoint into a file breakpoint
-					m_breakPoints[n].name           = file;
-					m_breakPoints[n].lineNbr        = lineNbr;
-					m_breakPoints[n].func           = false;
-					m_breakPoints[n].needsAdjusting = false;
-				}
-			}
-			// Check if a given breakpoint fall on a line with code or else adjust it to the next line
-			else if( m_breakPoints[n].needsAdjusting &&
-					 m_breakPoints[n].name == file )
-			{
-				int line = func->FindNextLineWithCode(m_breakPoints[n].lineNbr);
-				if( line >= 0 )
-				{
-					m_breakPoints[n].needsAdjusting = false;
-					if( line != m_breakPoints[n].lineNbr )
-					{
-						stringstream s;
-						s << "Moving break point " << n << " in file '" << file << "' to next line with code at line " << line << endl;
-						Output(s.str());
-
-						// Move the breakpoint to the next line
-						m_breakPoints[n].lineNbr = line;
-					}
-				}
+				stringstream s;
+				s << "Entering function '" << m_breakPoints[n].name << "'. Transforming it into break point" << endl;
+				Output(s.str());
+
+				// Transform the function breakpoint into a file breakpoint
+				m_breakPoints[n].name           = file;
+				m_breakPoints[n].lineNbr        = ctx->GetLineNumber(0, 0, 0);
+				m_breakPoints[n].func           = false;
+				m_breakPoints[n].needsAdjusting = false;
+				lines.push_back(asUINT(n));
 			}
+			continue;
 		}
-	}
-	m_lastFunction = func;
 
-	// Determine if there is a breakpoint at the current line
-	for( size_t n = 0; n < m_breakPoints.size(); n++ )
-	{
 		// TODO: do case-less comparison for file name
-
-		// Should we break?
-		if( !m_breakPoints[n].func &&
-			m_breakPoints[n].lineNbr == lineNbr &&
-			m_breakPoints[n].name == file )
+		if( m_breakPoints[n].name != file )
+			continue;
+
+		// Check if a given breakpoint fall on a line with code or else adjust it to the next line
+		int line = func->FindNextLineWithCode(m_breakPoints[n].lineNbr);
+		if( line < 0 )
+			continue;
+		if( m_breakPoints[n].needsAdjusting )
 		{
-			stringstream s;
-			s << "Reached break point " << n << " in file '" << file << "' at line " << lineNbr << endl;
-			Output(s.str());
-			return true;
+			m_breakPoints[n].needsAdjusting = false;
+			if( line != m_breakPoints[n].lineNbr )
+			{
+				stringstream s;
+				s << "Moving break point " << n << " in file '" << file << "' to next line with code at line " << line << endl;
+				Output(s.str());
+
+				// Move the breakpoint to the next line
+				m_breakPoints[n].lineNbr = line;
+			}
 		}
+
+		// The break point is inside this function if its line has code here
+		if( line == m_breakPoints[n].lineNbr )
+			lines.push_back(asUINT(n));
 	}
 
-	return false;
+	return &lines;
+}
+
+void CDebugger::ResetBreakPointCache()
+{
+	map<asIScriptFunction*, vector<asUINT> >::iterator it;
+	for( it = m_functionBreakPoints.begin(); it != m_functionBreakPoints.end(); ++it )
+		it->first->Release();
+	m_functionBreakPoints.clear();
+	m_lastFunctionBreakPoints = 0;
+	m_lastFunction = 0;
 }
 
 void CDebugger::TakeCommands(asIScriptContext *ctx)
@@ -374,13 +483,17 @@ bool CDebugger::InterpretCommand(const string &cmd, asIScriptContext *ctx)
 				if( br == "all" )
 				{
 					m_breakPoints.clear();
+					ResetBreakPointCache();
 					Output("All break points have been removed\n");
 				}
 				else
 				{
 					int nbr = atoi(br.c_str());
 					if( nbr >= 0 && nbr < (int)m_breakPoints.size() )
+					{
 						m_breakPoints.erase(m_breakPoints.begin()+nbr);
+						ResetBreakPointCache();
+					}
 					ListBreakPoints();
 				}
 			}
@@ -778,6 +891,8 @@ void CDebugger::AddFuncBreakPoint(const string &func)
 
 	BreakPoint bp(actual, 0, true);
 	m_breakPoints.push_back(bp);
+	ResetBreakPointCache();
+	UpdateLineCallbacks();
 }
 
 void CDebugger::AddFileBreakPoint(const string &file, int lineNbr)
@@ -801,6 +916,8 @@ void CDebugger::AddFileBreakPoint(const string &file, int lineNbr)
 
 	BreakPoint bp(actual, lineNbr, false);
 	m_breakPoints.push_back(bp);
+	ResetBreakPointCache();
+	UpdateLineCallbacks();
 }
 
 void CDebugger::PrintHelp()
@@ -32,6 +32,14 @@ public:
 	// Line callback invoked by context
 	virtual void LineCallback(asIScriptContext *ctx);
 
+	// Attached contexts only get the line callback while it is needed, i.e. while a step action
+	// is pending, a break has been requested or there are break points. Without any of those an
+	// attached context runs at full speed. These must be called from the thread running the scripts.
+	virtual void Attach(asIScriptContext *ctx);
+	virtual void Detach(asIScriptContext *ctx);
+	// Break at the next line executed by an attached context
+	virtual void RequestBreak();
+
 	// Commands
 	virtual void PrintHelp();
 	virtual void AddFileBreakPoint(const std::string &file, int lineNbr);
@@ -76,8 +84,23 @@ protected:
 	};
 	std::vector<BreakPoint> m_breakPoints;
 
+	// Break points resolved per function the first time the function is entered, as indices
+	// into m_breakPoints. Functions without break points get an empty list, so lines in them
+	// need no checks at all. The cache must be reset whenever m_breakPoints is modified.
+	std::map<asIScriptFunction*, std::vector<asUINT> > m_functionBreakPoints;
+	const std::vector<asUINT>                        *m_lastFunctionBreakPoints;
+	const std::vector<asUINT> *ResolveBreakPoints(asIScriptFunction *func, asIScriptContext *ctx);
+	void                       ResetBreakPointCache();
+
 	asIScriptEngine *m_engine;
 
+	// Contexts the line callback is installed on and removed from on demand
+	std::vector<asIScriptContext*> m_contexts;
+	bool                           m_lineCallbackInstalled;
+	bool                           m_breakRequested;
+	virtual bool NeedsLineCallback() const;
+	virtual void UpdateLineCallbacks();
+
 	// Registered callbacks for converting types to strings
 	std::map<const asITypeInfo*, ToStringCallback> m_toStringCallbacks;
 };
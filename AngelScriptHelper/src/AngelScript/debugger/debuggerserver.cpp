@@ -0,0 +1,435 @@
+#include "debuggerserver.h"
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <string.h>  // strcmp
+
+#ifdef _WIN32
+#include <winsock2.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "ws2_32.lib")
+#endif
+typedef int socklen_t;
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+typedef int SOCKET;
+#define INVALID_SOCKET (-1)
+#define closesocket close
+#endif
+
+using namespace std;
+using namespace rapidjson;
+
+BEGIN_AS_NAMESPACE
+
+static const asPWORD NO_SOCKET = asPWORD(-1);
+
+CDebuggerServer::CDebuggerServer()
+{
+	m_listenSocket = NO_SOCKET;
+	m_clientSocket = NO_SOCKET;
+	m_setupFinished = false;
+	m_hitBreakPoint = false;
+	m_expandMembersLevel = 3;
+}
+
+CDebuggerServer::~CDebuggerServer()
+{
+	Disconnect();
+	if( m_listenSocket != NO_SOCKET )
+	{
+		closesocket((SOCKET)m_listenSocket);
+#ifdef _WIN32
+		WSACleanup();
+#endif
+	}
+}
+
+bool CDebuggerServer::Listen(unsigned short port)
+{
+	if( m_listenSocket != NO_SOCKET )
+		return true;
+
+#ifdef _WIN32
+	WSADATA wsaData;
+	if( WSAStartup(MAKEWORD(2, 2), &wsaData) != 0 )
+		return false;
+#endif
+
+	SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if( s == INVALID_SOCKET )
+	{
+#ifdef _WIN32
+		WSACleanup();
+#endif
+		return false;
+	}
+
+	// Only accept connections from this machine
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	int reuse = 1;
+	setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+	if( ::bind(s, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(s, 1) != 0 )
+	{
+		closesocket(s);
+#ifdef _WIN32
+		WSACleanup();
+#endif
+		return false;
+	}
+
+	m_listenSocket = (asPWORD)s;
+	return true;
+}
+
+bool CDebuggerServer::IsConnected() const
+{
+	return m_clientSocket != NO_SOCKET;
+}
+
+// Returns true if the socket can be read without blocking
+static bool IsReadable(asPWORD socket)
+{
+	fd_set set;
+	FD_ZERO(&set);
+	FD_SET((SOCKET)socket, &set);
+	timeval timeout = { 0, 0 };
+	return select((int)((SOCKET)socket + 1), &set, 0, 0, &timeout) > 0;
+}
+
+bool CDebuggerServer::Accept(bool block)
+{
+	if( m_clientSocket != NO_SOCKET )
+		return true;
+	if( m_listenSocket == NO_SOCKET )
+		return false;
+	if( !block && !IsReadable(m_listenSocket) )
+		return false;
+
+	SOCKET s = accept((SOCKET)m_listenSocket, 0, 0);
+	if( s == INVALID_SOCKET )
+		return false;
+
+	// Messages are small and answered right away
+	int noDelay = 1;
+	setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+	m_clientSocket = (asPWORD)s;
+	m_received.clear();
+	m_setupFinished = false;
+	return true;
+}
+
+void CDebuggerServer::Disconnect()
+{
+	if( m_clientSocket == NO_SOCKET )
+		return;
+
+	closesocket((SOCKET)m_clientSocket);
+	m_clientSocket = NO_SOCKET;
+	m_received.clear();
+	m_setupFinished = false;
+
+	// Nobody is left to take commands, so let the scripts run freely
+	m_breakPoints.clear();
+	ResetBreakPointCache();
+	m_action = CONTINUE;
+	m_breakRequested = false;
+	UpdateLineCallbacks();
+}
+
+bool CDebuggerServer::WaitForClient()
+{
+	if( !Accept(true) )
+		return false;
+
+	string msg;
+	while( !m_setupFinished )
+	{
+		if( !ReadMessage(msg, true) )
+			return false;
+		HandleMessage(msg, 0);
+	}
+	return true;
+}
+
+void CDebuggerServer::Update()
+{
+	if( !Accept(false) )
+		return;
+
+	string msg;
+	while( ReadMessage(msg, false) )
+		HandleMessage(msg, 0);
+}
+
+bool CDebuggerServer::ReadMessage(string &msg, bool block)
+{
+	for(;;)
+	{
+		size_t end = m_received.find('\n');
+		if( end != string::npos )
+		{
+			msg.assign(m_received, 0, end);
+			m_received.erase(0, end + 1);
+			return true;
+		}
+
+		if( m_clientSocket == NO_SOCKET )
+			return false;
+		if( !block && !IsReadable(m_clientSocket) )
+			return false;
+
+		char buf[4096];
+		int r = recv((SOCKET)m_clientSocket, buf, sizeof(buf), 0);
+		if( r <= 0 )
+		{
+			Disconnect();
+			return false;
+		}
+		m_received.append(buf, r);
+	}
+}
+
+void CDebuggerServer::Send(const string &msg)
+{
+	if( m_clientSocket == NO_SOCKET )
+		return;
+
+	string data = msg + "\n";
+	size_t sent = 0;
+	while( sent < data.size() )
+	{
+		int r = send((SOCKET)m_clientSocket, data.c_str() + sent, int(data.size() - sent), 0);
+		if( r <= 0 )
+		{
+			Disconnect();
+			return;
+		}
+		sent += r;
+	}
+}
+
+void CDebuggerServer::Output(const string &str)
+{
+	if( m_clientSocket == NO_SOCKET )
+	{
+		CDebugger::Output(str);
+		return;
+	}
+
+	StringBuffer buffer;
+	Writer<StringBuffer> writer(buffer);
+	writer.StartObject();
+	writer.Key("Type");
+	writer.String("Output");
+	writer.Key("Text");
+	writer.String(str.c_str(), SizeType(str.size()));
+	writer.EndObject();
+	Send(buffer.GetString());
+}
+
+bool CDebuggerServer::CheckBreakPoint(asIScriptContext *ctx)
+{
+	// Remember if the line callback stops because of a break point or a step
+	bool hit = CDebugger::CheckBreakPoint(ctx);
+	if( hit )
+		m_hitBreakPoint = true;
+	return hit;
+}
+
+void CDebuggerServer::TakeCommands(asIScriptContext *ctx)
+{
+	if( m_clientSocket == NO_SOCKET )
+	{
+		m_hitBreakPoint = false;
+		m_action = CONTINUE;
+		return;
+	}
+
+	SendStop(ctx);
+	m_hitBreakPoint = false;
+
+	string msg;
+	while( ReadMessage(msg, true) )
+	{
+		if( HandleMessage(msg, ctx) )
+			return;
+	}
+	// The connection was lost, Disconnect has already let the script continue
+}
+
+bool CDebuggerServer::HandleMessage(const string &msg, asIScriptContext *ctx)
+{
+	Document doc;
+	doc.Parse(msg.c_str(), msg.size());
+	if( doc.HasParseError() || !doc.IsObject() || !doc.HasMember("Type") || !doc["Type"].IsString() )
+		return false;
+
+	const char *type = doc["Type"].GetString();
+	if( strcmp(type, "SetBreakpoints") == 0 )
+	{
+		if( !doc.HasMember("File") || !doc["File"].IsString() )
+			return false;
+
+		// Break points are stored with just the file name, not the entire path
+		string file = doc["File"].GetString();
+		size_t r = file.find_last_of("\\/");
+		if( r != string::npos )
+			file = file.substr(r+1);
+
+		// The message holds every break point of the file, so the old ones are replaced
+		for( size_t n = m_breakPoints.size(); n-- > 0; )
+		{
+			if( !m_breakPoints[n].func && m_breakPoints[n].name == file )
+				m_breakPoints.erase(m_breakPoints.begin()+n);
+		}
+		if( doc.HasMember("Breakpoints") && doc["Breakpoints"].IsArray() )
+		{
+			const Value &breakPoints = doc["Breakpoints"];
+			for( SizeType n = 0; n < breakPoints.Size(); n++ )
+			{
+				const Value &bp = breakPoints[n];
+				if( !bp.IsObject() || !bp.HasMember("Line") || !bp["Line"].IsInt() )
+					continue;
+				m_breakPoints.push_back(BreakPoint(file, bp["Line"].GetInt(), false));
+
+				if( bp.HasMember("ID") )
+				{
+					StringBuffer buffer;
+					Writer<StringBuffer> writer(buffer);
+					writer.StartObject();
+					writer.Key("Type");
+					writer.String("ValidatedBreakpoint");
+					writer.Key("ID");
+					bp["ID"].Accept(writer);
+					writer.EndObject();
+					Send(buffer.GetString());
+				}
+			}
+		}
+		ResetBreakPointCache();
+		UpdateLineCallbacks();
+		return false;
+	}
+	if( strcmp(type, "FinishedSetup") == 0 )
+	{
+		m_setupFinished = true;
+		return false;
+	}
+	if( strcmp(type, "Pause") == 0 )
+	{
+		// Already stopped if there is a context
+		if( ctx == 0 )
+			RequestBreak();
+		return false;
+	}
+
+	// The remaining commands only mean something while the script is stopped
+	if( ctx == 0 )
+		return false;
+	if( strcmp(type, "Continue") == 0 )
+		return InterpretCommand("c", ctx);
+	if( strcmp(type, "StepIn") == 0 )
+		return InterpretCommand("s", ctx);
+	if( strcmp(type, "StepOver") == 0 )
+		return InterpretCommand("n", ctx);
+	if( strcmp(type, "StepOut") == 0 )
+		return InterpretCommand("o", ctx);
+	return false;
+}
+
+static void WriteVariable(Writer<StringBuffer> &writer, CDebugger *dbg, const char *decl, void *ptr, int typeId, int expandMembersLevel, asIScriptEngine *engine)
+{
+	writer.StartObject();
+	writer.Key("Declaration");
+	writer.String(decl ? decl : "");
+	writer.Key("Value");
+	writer.String(dbg->ToString(ptr, typeId, 0, engine).c_str());
+
+	// Members of script objects are sent as their own variables so they can be expanded
+	if( ptr && expandMembersLevel > 0 && (typeId & asTYPEID_SCRIPTOBJECT) )
+	{
+		asIScriptObject *obj = (asIScriptObject*)((typeId & asTYPEID_OBJHANDLE) ? *(void**)ptr : ptr);
+		if( obj && obj->GetPropertyCount() )
+		{
+			asITypeInfo *type = obj->GetObjectType();
+			writer.Key("Properties");
+			writer.StartArray();
+			for( asUINT n = 0; n < obj->GetPropertyCount(); n++ )
+				WriteVariable(writer, dbg, type->GetPropertyDeclaration(n), obj->GetAddressOfProperty(n), obj->GetPropertyTypeId(n), expandMembersLevel - 1, engine);
+			writer.EndArray();
+		}
+	}
+	writer.EndObject();
+}
+
+void CDebuggerServer::SendStop(asIScriptContext *ctx)
+{
+	asIScriptEngine *engine = ctx->GetEngine();
+	StringBuffer buffer;
+	Writer<StringBuffer> writer(buffer);
+	writer.StartObject();
+	writer.Key("Type");
+	writer.String(m_hitBreakPoint ? "HitBreakpoint" : "Step");
+	writer.Key("Line");
+	writer.Int(ctx->GetLineNumber(0, 0, 0));
+
+	writer.Key("CallStack");
+	writer.StartArray();
+	for( asUINT n = 0; n < ctx->GetCallstackSize(); n++ )
+	{
+		asIScriptFunction *func = ctx->GetFunction(n);
+		const char *file = 0;
+		int lineNbr = ctx->GetLineNumber(n, 0, &file);
+		writer.StartObject();
+		writer.Key("Line");
+		writer.Int(lineNbr);
+		writer.Key("File");
+		writer.String(file ? file : "{unnamed}");
+		writer.Key("Declaration");
+		writer.String(func ? func->GetDeclaration() : "{unnamed}");
+		writer.Key("Variables");
+		writer.StartArray();
+		if( func )
+		{
+			if( ctx->GetThisPointer(n) )
+				WriteVariable(writer, this, "this", ctx->GetThisPointer(n), ctx->GetThisTypeId(n), m_expandMembersLevel, engine);
+			for( asUINT v = 0; v < func->GetVarCount(); v++ )
+			{
+				if( ctx->IsVarInScope(v, n) )
+					WriteVariable(writer, this, func->GetVarDecl(v), ctx->GetAddressOfVar(v, n), ctx->GetVarTypeId(v, n), m_expandMembersLevel, engine);
+			}
+		}
+		writer.EndArray();
+		writer.EndObject();
+	}
+	writer.EndArray();
+
+	writer.Key("GlobalVars");
+	writer.StartArray();
+	asIScriptFunction *func = ctx->GetFunction();
+	asIScriptModule *mod = func ? func->GetModule() : 0;
+	if( mod )
+	{
+		for( asUINT n = 0; n < mod->GetGlobalVarCount(); n++ )
+		{
+			int typeId = 0;
+			mod->GetGlobalVar(n, 0, 0, &typeId);
+			WriteVariable(writer, this, mod->GetGlobalVarDeclaration(n), mod->GetAddressOfGlobalVar(n), typeId, m_expandMembersLevel, engine);
+		}
+	}
+	writer.EndArray();
+	writer.EndObject();
+	Send(buffer.GetString());
+}
+
+END_AS_NAMESPACE
@@ -0,0 +1,58 @@
+#ifndef DEBUGGERSERVER_H
+#define DEBUGGERSERVER_H
+
+#include "debugger.h"
+
+BEGIN_AS_NAMESPACE
+
+// Debugger that is driven by the debug adapter of the vscode extension instead of the console.
+// It listens on a local TCP port and speaks newline separated JSON messages:
+//  adapter -> script:  SetBreakpoints {File, Breakpoints: [{Line, ID}]}, FinishedSetup,
+//                      Continue, StepIn, StepOver, StepOut, Pause
+//  script -> adapter:  ValidatedBreakpoint {ID}, HitBreakpoint / Step {Line, CallStack, GlobalVars},
+//                      Output {Text}
+// All break points of a file are replaced by a single SetBreakpoints message, and the call stack
+// with the variables of every frame and the globals is sent in the message that reports a stop.
+class CDebuggerServer : public CDebugger
+{
+public:
+	CDebuggerServer();
+	virtual ~CDebuggerServer();
+
+	// Starts listening on 127.0.0.1:port
+	virtual bool Listen(unsigned short port);
+	// Blocks until a client has connected and finished sending its break points, so that
+	// break points in code that runs at startup can be hit
+	virtual bool WaitForClient();
+	// Accepts a client and handles the messages that arrived while the scripts were running
+	// without blocking. Call it regularly, e.g. once per frame, from the thread running the scripts.
+	virtual void Update();
+	bool IsConnected() const;
+
+	// CDebugger
+	virtual void TakeCommands(asIScriptContext *ctx);
+	virtual void Output(const std::string &str);
+	virtual bool CheckBreakPoint(asIScriptContext *ctx);
+
+	// How many levels of members are sent for objects in the variables
+	int m_expandMembersLevel;
+
+protected:
+	// Returns true if the message resumes the execution
+	virtual bool HandleMessage(const std::string &msg, asIScriptContext *ctx);
+	virtual void SendStop(asIScriptContext *ctx);
+	void         Send(const std::string &msg);
+	bool         ReadMessage(std::string &msg, bool block);
+	bool         Accept(bool block);
+	void         Disconnect();
+
+	asPWORD     m_listenSocket;
+	asPWORD     m_clientSocket;
+	std::string m_received;
+	bool        m_setupFinished;
+	bool        m_hitBreakPoint;
+};
+
+END_AS_NAMESPACE
+
+#endif
@@ -0,0 +1,275 @@
+#include "profiler.h"
+#include <rapidjson/filewritestream.h>
+#include <rapidjson/writer.h>
+#include <algorithm>  // sort
+#include <functional> // greater
+#include <stdio.h>    // fopen
+
+using namespace std;
+using namespace rapidjson;
+
+BEGIN_AS_NAMESPACE
+
+CProfiler::CProfiler()
+{
+	m_running = false;
+	m_sampleEvery = 16;
+	m_linesToSample = m_sampleEvery;
+	m_minInterval = 0.0001;
+	m_executionDepth = 0;
+	m_sampleCount = 0;
+	m_totalTime = 0;
+}
+
+CProfiler::~CProfiler()
+{
+	while( m_contexts.size() )
+		Detach(m_contexts.back());
+	Reset();
+}
+
+void CProfiler::SetSampling(asUINT lineCallbacks, double minInterval)
+{
+	m_sampleEvery = lineCallbacks ? lineCallbacks : 1;
+	m_linesToSample = m_sampleEvery;
+	m_minInterval = minInterval;
+}
+
+void CProfiler::BeginExecution()
+{
+	if( m_executionDepth++ == 0 )
+	{
+		m_linesToSample = m_sampleEvery;
+		m_lastSample = Clock::now();
+	}
+}
+
+void CProfiler::EndExecution()
+{
+	if( m_executionDepth > 0 )
+		m_executionDepth--;
+}
+
+int CProfiler::Execute(asIScriptContext *ctx)
+{
+	BeginExecution();
+	int r = ctx->Execute();
+	EndExecution();
+	return r;
+}
+
+void CProfiler::Attach(asIScriptContext *ctx)
+{
+	if( ctx == 0 || find(m_contexts.begin(), m_contexts.end(), ctx) != m_contexts.end() )
+		return;
+
+	ctx->AddRef();
+	ctx->SetLineCallback(asMETHOD(CProfiler, LineCallback), this, asCALL_THISCALL);
+	m_contexts.push_back(ctx);
+}
+
+void CProfiler::Detach(asIScriptContext *ctx)
+{
+	vector<asIScriptContext*>::iterator it = find(m_contexts.begin(), m_contexts.end(), ctx);
+	if( it == m_contexts.end() )
+		return;
+
+	ctx->ClearLineCallback();
+	ctx->Release();
+	m_contexts.erase(it);
+}
+
+void CProfiler::Start()
+{
+	m_running = true;
+	m_linesToSample = m_sampleEvery;
+	m_lastSample = Clock::now();
+}
+
+void CProfiler::Stop()
+{
+	m_running = false;
+}
+
+void CProfiler::Reset()
+{
+	map<asIScriptFunction*, FunctionStats>::iterator it;
+	for( it = m_functions.begin(); it != m_functions.end(); ++it )
+		it->first->Release();
+	m_functions.clear();
+	m_stacks.clear();
+	m_sampleCount = 0;
+	m_totalTime = 0;
+	m_lastSample = Clock::now();
+}
+
+void CProfiler::LineCallback(asIScriptContext *ctx)
+{
+	if( !m_running || m_executionDepth == 0 )
+		return;
+
+	// Reading the clock on every line would cost more than the sampling itself
+	if( --m_linesToSample > 0 )
+		return;
+	m_linesToSample = m_sampleEvery;
+
+	Clock::time_point now = Clock::now();
+	double elapsed = chrono::duration<double>(now - m_lastSample).count();
+	if( elapsed < m_minInterval )
+		return;
+	m_lastSample = now;
+
+	Sample(ctx, elapsed);
+}
+
+CProfiler::FunctionStats &CProfiler::GetStats(asIScriptFunction *func)
+{
+	map<asIScriptFunction*, FunctionStats>::iterator it = m_functions.find(func);
+	if( it != m_functions.end() )
+		return it->second;
+
+	// Keep the function alive so the address isn't reused while it is in the results
+	func->AddRef();
+	return m_functions[func];
+}
+
+void CProfiler::Sample(asIScriptContext *ctx, double weight)
+{
+	m_sampleCount++;
+	m_totalTime += weight;
+
+	// Outermost function first, like the folded stack format
+	m_stack.clear();
+	asUINT size = ctx->GetCallstackSize();
+	for( asUINT n = size; n-- > 0; )
+	{
+		asIScriptFunction *func = ctx->GetFunction(n);
+		if( func == 0 )
+			continue;
+
+		FunctionStats &stats = GetStats(func);
+		int lineNbr = ctx->GetLineNumber(n);
+		if( stats.lastSample != m_sampleCount )
+		{
+			stats.lastSample = m_sampleCount;
+			stats.inclusive += weight;
+			stats.samples++;
+		}
+		LineStats &line = stats.lines[lineNbr];
+		if( line.lastSample != m_sampleCount )
+		{
+			line.lastSample = m_sampleCount;
+			line.inclusive += weight;
+		}
+		if( n == 0 )
+		{
+			stats.exclusive += weight;
+			line.exclusive += weight;
+		}
+		m_stack.push_back(func);
+	}
+	if( m_stack.size() )
+		m_stacks[m_stack] += weight;
+}
+
+static string GetFunctionName(asIScriptFunction *func)
+{
+	string name;
+	if( func->GetModuleName() )
+		name = string(func->GetModuleName()) + "!";
+	return name + func->GetDeclaration(true, true, false);
+}
+
+bool CProfiler::WriteFoldedStacks(const char *file) const
+{
+	FILE *f = fopen(file, "w");
+	if( f == 0 )
+		return false;
+
+	map<asIScriptFunction*, string> names;
+	map<vector<asIScriptFunction*>, double>::const_iterator it;
+	for( it = m_stacks.begin(); it != m_stacks.end(); ++it )
+	{
+		string line;
+		for( size_t n = 0; n < it->first.size(); n++ )
+		{
+			string &name = names[it->first[n]];
+			if( name.empty() )
+			{
+				name = GetFunctionName(it->first[n]);
+				// ';' separates the frames
+				replace(name.begin(), name.end(), ';', ',');
+			}
+			if( n )
+				line += ";";
+			line += name;
+		}
+		fprintf(f, "%s %.0f\n", line.c_str(), it->second * 1000000.0);
+	}
+	fclose(f);
+	return true;
+}
+
+bool CProfiler::WriteReport(const char *file) const
+{
+	FILE *f = fopen(file, "wb");
+	if( f == 0 )
+		return false;
+
+	// Most expensive functions first
+	vector<pair<double, asIScriptFunction*> > order;
+	map<asIScriptFunction*, FunctionStats>::const_iterator it;
+	for( it = m_functions.begin(); it != m_functions.end(); ++it )
+		order.push_back(make_pair(it->second.exclusive, it->first));
+	sort(order.begin(), order.end(), greater<pair<double, asIScriptFunction*> >());
+
+	char buffer[65536];
+	FileWriteStream stream(f, buffer, sizeof(buffer));
+	Writer<FileWriteStream> writer(stream);
+	writer.StartObject();
+	writer.Key("TotalTime");
+	writer.Double(m_totalTime);
+	writer.Key("Samples");
+	writer.Uint(m_sampleCount);
+	writer.Key("Functions");
+	writer.StartArray();
+	for( size_t n = 0; n < order.size(); n++ )
+	{
+		asIScriptFunction *func = order[n].second;
+		const FunctionStats &stats = m_functions.find(func)->second;
+		writer.StartObject();
+		writer.Key("Name");
+		writer.String(GetFunctionName(func).c_str());
+		writer.Key("Section");
+		writer.String(func->GetScriptSectionName() ? func->GetScriptSectionName() : "");
+		writer.Key("Inclusive");
+		writer.Double(stats.inclusive);
+		writer.Key("Exclusive");
+		writer.Double(stats.exclusive);
+		writer.Key("Samples");
+		writer.Uint(stats.samples);
+		writer.Key("Lines");
+		writer.StartArray();
+		map<int, LineStats>::const_iterator line;
+		for( line = stats.lines.begin(); line != stats.lines.end(); ++line )
+		{
+			writer.StartObject();
+			writer.Key("Line");
+			writer.Int(line->first);
+			writer.Key("Inclusive");
+			writer.Double(line->second.inclusive);
+			writer.Key("Exclusive");
+			writer.Double(line->second.exclusive);
+			writer.EndObject();
+		}
+		writer.EndArray();
+		writer.EndObject();
+	}
+	writer.EndArray();
+	writer.EndObject();
+	stream.Flush();
+	fclose(f);
+	return true;
+}
+
+END_AS_NAMESPACE
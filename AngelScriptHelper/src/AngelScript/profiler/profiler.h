@@ -0,0 +1,94 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#ifndef ANGELSCRIPT_H
+// Avoid having to inform include path if header is already include before
+#include <angelscript.h>
+#endif
+
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+
+BEGIN_AS_NAMESPACE
+
+// Sampling profiler for scripts. The call stack of the context is sampled from the line callback
+// and every sample is weighted with the time that passed since the previous one, which gives the
+// inclusive and exclusive time of each function and line without instrumenting the scripts.
+class CProfiler
+{
+public:
+	CProfiler();
+	virtual ~CProfiler();
+
+	// The clock is only read every lineCallbacks lines, and a sample is taken once at least
+	// minInterval seconds have passed.
+	void SetSampling(asUINT lineCallbacks, double minInterval);
+
+	// Samples are only taken between BeginExecution and EndExecution, and the first one is timed
+	// from BeginExecution, so the time the scripts aren't running, e.g. between frames, isn't
+	// attributed to any function. Nested calls are counted, only the outermost pair is a boundary.
+	// Execute calls ctx->Execute between them.
+	void BeginExecution();
+	void EndExecution();
+	int  Execute(asIScriptContext *ctx);
+
+	// Sets the line callback of the context to the profiler. If the application needs the line
+	// callback for something else it can forward the calls to LineCallback instead.
+	virtual void Attach(asIScriptContext *ctx);
+	virtual void Detach(asIScriptContext *ctx);
+	virtual void LineCallback(asIScriptContext *ctx);
+
+	void Start();
+	void Stop();
+	void Reset();
+	bool IsRunning() const { return m_running; }
+
+	// Folded stacks, one "outer;inner;innermost <microseconds>" per line, for flamegraph.pl and speedscope
+	virtual bool WriteFoldedStacks(const char *file) const;
+	// Per function and per line inclusive and exclusive time in seconds, sorted on exclusive time
+	virtual bool WriteReport(const char *file) const;
+
+protected:
+	virtual void Sample(asIScriptContext *ctx, double weight);
+
+	struct LineStats
+	{
+		LineStats() : inclusive(0), exclusive(0), lastSample(0) {}
+		double inclusive;
+		double exclusive;
+		asUINT lastSample; // recursive calls only count once per sample
+	};
+	struct FunctionStats
+	{
+		FunctionStats() : inclusive(0), exclusive(0), samples(0), lastSample(0) {}
+		double                   inclusive;
+		double                   exclusive;
+		asUINT                   samples;
+		asUINT                   lastSample; // recursive calls only count once per sample
+		std::map<int, LineStats> lines;
+	};
+	FunctionStats &GetStats(asIScriptFunction *func);
+
+	typedef std::chrono::steady_clock Clock;
+
+	bool              m_running;
+	asUINT            m_sampleEvery;
+	asUINT            m_linesToSample;
+	double            m_minInterval;
+	asUINT            m_executionDepth;
+	Clock::time_point m_lastSample;
+	asUINT            m_sampleCount;
+	double            m_totalTime;
+
+	// The profiler holds a reference to every function in here
+	std::map<asIScriptFunction*, FunctionStats>            m_functions;
+	std::map<std::vector<asIScriptFunction*>, double>      m_stacks;
+	std::vector<asIScriptFunction*>                        m_stack;
+	std::vector<asIScriptContext*>                         m_contexts;
+};
+
+END_AS_NAMESPACE
+
+#endif
@@ -1,11 +1,24 @@
 #include <new>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h> // offsetof
 #include <assert.h>
 #include <stdio.h> // sprintf
 #include <string>
+#include <algorithm> // std::sort
+
+// The kernels for arrays of primitives compare 16 bytes at a time when the target has
+// SSE2. Define AS_ARRAY_NO_SIMD to only use the scalar versions.
+#if !defined(AS_ARRAY_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define AS_ARRAY_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h> // _BitScanForward
+#endif
+#endif
 
 #include "scriptarray.h"
+#include "../scriptpool/scriptpool.h"
 
 using namespace std;
 
@@ -16,9 +29,14 @@ BEGIN_AS_NAMESPACE
 #define UNUSED_VAR(x) (void)(x)
 
 // Set the default memory routines
-// Use the angelscript engine's memory routines by default
+// Use the pooled allocator by default, or the angelscript engine's memory routines
+#if AS_USE_SCRIPTPOOL
+static asALLOCFUNC_t userAlloc = ScriptPoolAlloc;
+static asFREEFUNC_t  userFree  = ScriptPoolFree;
+#else
 static asALLOCFUNC_t userAlloc = asAllocMem;
 static asFREEFUNC_t  userFree  = asFreeMem;
+#endif
 
 // Allows the application to set which memory routines should be used by the array object
 void CScriptArray::SetMemoryFunctions(asALLOCFUNC_t allocFunc, asFREEFUNC_t freeFunc)
@@ -29,6 +47,10 @@ void CScriptArray::SetMemoryFunctions(asALLOCFUNC_t allocFunc, asFREEFUNC_t free
 
 static void RegisterScriptArray_Native(asIScriptEngine *engine);
 static void RegisterScriptArray_Generic(asIScriptEngine *engine);
+static void ScriptArraySum_Generic(asIScriptGeneric *gen);
+static void ScriptArrayMin_Generic(asIScriptGeneric *gen);
+static void ScriptArrayMax_Generic(asIScriptGeneric *gen);
+static void ScriptArrayDot_Generic(asIScriptGeneric *gen);
 
 struct SArrayBuffer
 {
@@ -60,6 +82,370 @@ static void CleanupTypeInfoArrayCache(asITypeInfo *type)
 	}
 }
 
+// Bulk math on arrays of numbers. Values and results are passed by the address of an element.
+struct SArrayMath
+{
+	void (*sum)(const void *data, asUINT count, void *result);
+	void (*min)(const void *data, asUINT count, void *result);
+	void (*max)(const void *data, asUINT count, void *result);
+	void (*dot)(const void *a, const void *b, asUINT count, void *result);
+	void (*scale)(void *data, asUINT count, const void *factor);
+	void (*add)(void *data, const void *other, asUINT count);
+	void (*fill)(void *data, asUINT count, const void *value);
+};
+
+// Operations on the buffer that are specialized for the type of the elements.
+// Signed and unsigned integers share the kernels as only equality is needed.
+struct SArrayKernels
+{
+	// Returns the index of the first element in [start, end) equal to value, or -1
+	int  (*find)(const void *data, asUINT start, asUINT end, const void *value);
+	bool (*equals)(const void *a, const void *b, asUINT count);
+	void (*reverse)(void *data, asUINT count);
+
+	// Only set for the number types
+	const SArrayMath *math;
+};
+
+#ifdef AS_ARRAY_SSE2
+// Compares and shuffles of 16 bytes of elements of type T
+template<class T> struct SArrayVector;
+
+template<> struct SArrayVector<asWORD>
+{
+	static __m128i Splat(asWORD v) { return _mm_set1_epi16((short)v); }
+	static __m128i Equal(__m128i a, __m128i b) { return _mm_cmpeq_epi16(a, b); }
+	static __m128i Reverse(__m128i v)
+	{
+		v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0,1,2,3));
+		v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0,1,2,3));
+		return _mm_shuffle_epi32(v, _MM_SHUFFLE(1,0,3,2));
+	}
+};
+
+template<> struct SArrayVector<asBYTE>
+{
+	static __m128i Splat(asBYTE v) { return _mm_set1_epi8((char)v); }
+	static __m128i Equal(__m128i a, __m128i b) { return _mm_cmpeq_epi8(a, b); }
+	static __m128i Reverse(__m128i v)
+	{
+		// Swap the bytes of each word, then reverse the words
+		v = _mm_or_si128(_mm_srli_epi16(v, 8), _mm_slli_epi16(v, 8));
+		return SArrayVector<asWORD>::Reverse(v);
+	}
+};
+
+template<> struct SArrayVector<asDWORD>
+{
+	static __m128i Splat(asDWORD v) { return _mm_set1_epi32((int)v); }
+	static __m128i Equal(__m128i a, __m128i b) { return _mm_cmpeq_epi32(a, b); }
+	static __m128i Reverse(__m128i v) { return _mm_shuffle_epi32(v, _MM_SHUFFLE(0,1,2,3)); }
+};
+
+template<> struct SArrayVector<asQWORD>
+{
+	static __m128i Splat(asQWORD v) { return _mm_set1_epi64x((long long)v); }
+	static __m128i Equal(__m128i a, __m128i b)
+	{
+		// SSE2 has no 64 bit compare, both halves must be equal
+		__m128i e = _mm_cmpeq_epi32(a, b);
+		return _mm_and_si128(e, _mm_shuffle_epi32(e, _MM_SHUFFLE(2,3,0,1)));
+	}
+	static __m128i Reverse(__m128i v) { return _mm_shuffle_epi32(v, _MM_SHUFFLE(1,0,3,2)); }
+};
+
+// Floats are compared as values, so NaN never matches and 0 matches -0
+template<> struct SArrayVector<float>
+{
+	static __m128i Splat(float v) { return _mm_castps_si128(_mm_set1_ps(v)); }
+	static __m128i Equal(__m128i a, __m128i b) { return _mm_castps_si128(_mm_cmpeq_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b))); }
+	static __m128i Reverse(__m128i v) { return SArrayVector<asDWORD>::Reverse(v); }
+};
+
+template<> struct SArrayVector<double>
+{
+	static __m128i Splat(double v) { return _mm_castpd_si128(_mm_set1_pd(v)); }
+	static __m128i Equal(__m128i a, __m128i b) { return _mm_castpd_si128(_mm_cmpeq_pd(_mm_castsi128_pd(a), _mm_castsi128_pd(b))); }
+	static __m128i Reverse(__m128i v) { return SArrayVector<asQWORD>::Reverse(v); }
+};
+
+static inline __m128i LoadVector(const void *p)
+{
+	return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+// Index of the lowest set bit, mask must not be 0
+static inline asUINT FirstBit(int mask)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, (unsigned long)mask);
+	return index;
+#else
+	return __builtin_ctz((unsigned)mask);
+#endif
+}
+#endif
+
+template<class T>
+static int FindKernel(const void *data, asUINT start, asUINT end, const void *value)
+{
+	const T *p = reinterpret_cast<const T*>(data);
+	T v;
+	memcpy(&v, value, sizeof(T));
+
+	asUINT i = start;
+#ifdef AS_ARRAY_SSE2
+	const asUINT n = 16 / sizeof(T);
+	const __m128i splat = SArrayVector<T>::Splat(v);
+
+	// Look for a match in 64 bytes at a time, which keeps up with the memory bandwidth
+	for( ; end - i >= 4*n; i += 4*n )
+	{
+		__m128i e0 = SArrayVector<T>::Equal(LoadVector(p + i), splat);
+		__m128i e1 = SArrayVector<T>::Equal(LoadVector(p + i + n), splat);
+		__m128i e2 = SArrayVector<T>::Equal(LoadVector(p + i + 2*n), splat);
+		__m128i e3 = SArrayVector<T>::Equal(LoadVector(p + i + 3*n), splat);
+		if( _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(e0, e1), _mm_or_si128(e2, e3))) )
+			break;
+	}
+
+	// Locate it within the vector
+	for( ; end - i >= n; i += n )
+	{
+		int mask = _mm_movemask_epi8(SArrayVector<T>::Equal(LoadVector(p + i), splat));
+		if( mask )
+			return int(i + FirstBit(mask) / sizeof(T));
+	}
+#endif
+
+	for( ; i < end; i++ )
+	{
+		if( p[i] == v )
+			return int(i);
+	}
+
+	return -1;
+}
+
+// Integers are equal when their bits are
+template<class T>
+static bool EqualsKernel(const void *a, const void *b, asUINT count)
+{
+	return memcmp(a, b, count * sizeof(T)) == 0;
+}
+
+// Floats are compared as values
+template<class T>
+static bool FloatEqualsKernel(const void *a, const void *b, asUINT count)
+{
+	const T *pa = reinterpret_cast<const T*>(a);
+	const T *pb = reinterpret_cast<const T*>(b);
+
+	asUINT i = 0;
+#ifdef AS_ARRAY_SSE2
+	const asUINT n = 16 / sizeof(T);
+	for( ; count - i >= n; i += n )
+	{
+		if( _mm_movemask_epi8(SArrayVector<T>::Equal(LoadVector(pa + i), LoadVector(pb + i))) != 0xFFFF )
+			return false;
+	}
+#endif
+
+	for( ; i < count; i++ )
+	{
+		if( !(pa[i] == pb[i]) )
+			return false;
+	}
+
+	return true;
+}
+
+template<class T>
+static void ReverseKernel(void *data, asUINT count)
+{
+	T *lo = reinterpret_cast<T*>(data);
+	T *hi = lo + count;
+
+#ifdef AS_ARRAY_SSE2
+	// Swap reversed vectors from both ends until they meet
+	const asUINT n = 16 / sizeof(T);
+	while( asUINT(hi - lo) >= 2*n )
+	{
+		hi -= n;
+		__m128i a = LoadVector(lo);
+		__m128i b = LoadVector(hi);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(lo), SArrayVector<T>::Reverse(b));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(hi), SArrayVector<T>::Reverse(a));
+		lo += n;
+	}
+#endif
+
+	std::reverse(lo, hi);
+}
+
+// The integer kernels calculate in an unsigned type and cast the result back, so overflow
+// wraps around instead of being undefined. The type is at least as large as an int, as
+// smaller types would be promoted to int before the arithmetic.
+template<class T> struct SArrayArith                { typedef T       type; }; // float and double
+template<>        struct SArrayArith<signed char>   { typedef asDWORD type; };
+template<>        struct SArrayArith<asBYTE>        { typedef asDWORD type; };
+template<>        struct SArrayArith<signed short>  { typedef asDWORD type; };
+template<>        struct SArrayArith<asWORD>        { typedef asDWORD type; };
+template<>        struct SArrayArith<signed int>    { typedef asDWORD type; };
+template<>        struct SArrayArith<asDWORD>       { typedef asDWORD type; };
+template<>        struct SArrayArith<asINT64>       { typedef asQWORD type; };
+template<>        struct SArrayArith<asQWORD>       { typedef asQWORD type; };
+
+// The math kernels are plain loops over the typed elements, which the compiler vectorizes.
+// The sums are split in four, so the additions don't have to wait for each other.
+template<class T>
+static void SumKernel(const void *data, asUINT count, void *result)
+{
+	typedef typename SArrayArith<T>::type A;
+	const T *p = reinterpret_cast<const T*>(data);
+	A s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	asUINT i = 0;
+	for( ; i + 4 <= count; i += 4 )
+	{
+		s0 += A(p[i]);
+		s1 += A(p[i + 1]);
+		s2 += A(p[i + 2]);
+		s3 += A(p[i + 3]);
+	}
+	for( ; i < count; i++ )
+		s0 += A(p[i]);
+
+	T sum = T((s0 + s1) + (s2 + s3));
+	memcpy(result, &sum, sizeof(T));
+}
+
+template<class T>
+static void DotKernel(const void *a, const void *b, asUINT count, void *result)
+{
+	typedef typename SArrayArith<T>::type A;
+	const T *pa = reinterpret_cast<const T*>(a);
+	const T *pb = reinterpret_cast<const T*>(b);
+	A s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	asUINT i = 0;
+	for( ; i + 4 <= count; i += 4 )
+	{
+		s0 += A(pa[i]) * A(pb[i]);
+		s1 += A(pa[i + 1]) * A(pb[i + 1]);
+		s2 += A(pa[i + 2]) * A(pb[i + 2]);
+		s3 += A(pa[i + 3]) * A(pb[i + 3]);
+	}
+	for( ; i < count; i++ )
+		s0 += A(pa[i]) * A(pb[i]);
+
+	T sum = T((s0 + s1) + (s2 + s3));
+	memcpy(result, &sum, sizeof(T));
+}
+
+// count must not be 0. NaN is skipped unless it is the first element.
+template<class T>
+static void MinKernel(const void *data, asUINT count, void *result)
+{
+	const T *p = reinterpret_cast<const T*>(data);
+	T m = p[0];
+	for( asUINT i = 1; i < count; i++ )
+		m = p[i] < m ? p[i] : m;
+	memcpy(result, &m, sizeof(T));
+}
+
+template<class T>
+static void MaxKernel(const void *data, asUINT count, void *result)
+{
+	const T *p = reinterpret_cast<const T*>(data);
+	T m = p[0];
+	for( asUINT i = 1; i < count; i++ )
+		m = m < p[i] ? p[i] : m;
+	memcpy(result, &m, sizeof(T));
+}
+
+template<class T>
+static void ScaleKernel(void *data, asUINT count, const void *factor)
+{
+	typedef typename SArrayArith<T>::type A;
+	T *p = reinterpret_cast<T*>(data);
+	T f;
+	memcpy(&f, factor, sizeof(T));
+	for( asUINT i = 0; i < count; i++ )
+		p[i] = T(A(p[i]) * A(f));
+}
+
+template<class T>
+static void AddKernel(void *data, const void *other, asUINT count)
+{
+	typedef typename SArrayArith<T>::type A;
+	T *p = reinterpret_cast<T*>(data);
+	const T *q = reinterpret_cast<const T*>(other);
+	for( asUINT i = 0; i < count; i++ )
+		p[i] = T(A(p[i]) + A(q[i]));
+}
+
+template<class T>
+static void FillKernel(void *data, asUINT count, const void *value)
+{
+	T *p = reinterpret_cast<T*>(data);
+	T v;
+	memcpy(&v, value, sizeof(T));
+	for( asUINT i = 0; i < count; i++ )
+		p[i] = v;
+}
+
+// N is the number type, or void for types without math
+template<class N>
+struct SArrayMathOf
+{
+	static const SArrayMath *Get()
+	{
+		static const SArrayMath math = { SumKernel<N>, MinKernel<N>, MaxKernel<N>, DotKernel<N>, ScaleKernel<N>, AddKernel<N>, FillKernel<N> };
+		return &math;
+	}
+};
+
+template<>
+struct SArrayMathOf<void>
+{
+	static const SArrayMath *Get() { return 0; }
+};
+
+template<class T, bool (*EQUALS)(const void*, const void*, asUINT), class N>
+static const SArrayKernels *ArrayKernels()
+{
+	static const SArrayKernels kernels = { FindKernel<T>, EQUALS, ReverseKernel<T>, SArrayMathOf<N>::Get() };
+	return &kernels;
+}
+
+// Selects the kernels for the subtype. Arrays of objects and handles store pointers, their
+// kernels find and move the pointers.
+static const SArrayKernels *GetArrayKernels(int subTypeId)
+{
+	if( subTypeId & asTYPEID_MASK_OBJECT )
+	{
+		if( sizeof(asPWORD) == 8 )
+			return ArrayKernels<asQWORD, EqualsKernel<asQWORD>, void>();
+		return ArrayKernels<asDWORD, EqualsKernel<asDWORD>, void>();
+	}
+
+	switch( subTypeId )
+	{
+	case asTYPEID_BOOL:   return ArrayKernels<asBYTE, EqualsKernel<asBYTE>, void>();
+	case asTYPEID_INT8:   return ArrayKernels<asBYTE, EqualsKernel<asBYTE>, signed char>();
+	case asTYPEID_UINT8:  return ArrayKernels<asBYTE, EqualsKernel<asBYTE>, asBYTE>();
+	case asTYPEID_INT16:  return ArrayKernels<asWORD, EqualsKernel<asWORD>, signed short>();
+	case asTYPEID_UINT16: return ArrayKernels<asWORD, EqualsKernel<asWORD>, asWORD>();
+	case asTYPEID_INT32:  return ArrayKernels<asDWORD, EqualsKernel<asDWORD>, signed int>();
+	case asTYPEID_UINT32: return ArrayKernels<asDWORD, EqualsKernel<asDWORD>, asDWORD>();
+	case asTYPEID_INT64:  return ArrayKernels<asQWORD, EqualsKernel<asQWORD>, asINT64>();
+	case asTYPEID_UINT64: return ArrayKernels<asQWORD, EqualsKernel<asQWORD>, asQWORD>();
+	case asTYPEID_FLOAT:  return ArrayKernels<float, FloatEqualsKernel<float>, float>();
+	case asTYPEID_DOUBLE: return ArrayKernels<double, FloatEqualsKernel<double>, double>();
+	default:              return ArrayKernels<asDWORD, EqualsKernel<asDWORD>, void>(); // All enums
+	}
+}
+
 CScriptArray* CScriptArray::Create(asITypeInfo *ti, asUINT length)
 {
 	// Allocate the memory
@@ -304,10 +690,15 @@ static void RegisterScriptArray_Native(asIScriptEngine *engine)
 #endif
 	r = engine->RegisterObjectMethod("array<T>", "void reserve(uint length)", asMETHOD(CScriptArray, Reserve), asCALL_THISCALL); assert( r >= 0 );
 	r = engine->RegisterObjectMethod("array<T>", "void resize(uint length)", asMETHODPR(CScriptArray, Resize, (asUINT), void), asCALL_THISCALL); assert( r >= 0 );
+	r = engine->RegisterObjectMethod("array<T>", "void shrinkToFit()", asMETHOD(CScriptArray, ShrinkToFit), asCALL_THISCALL); assert( r >= 0 );
 	r = engine->RegisterObjectMethod("array<T>", "void sortAsc()", asMETHODPR(CScriptArray, SortAsc, (), void), asCALL_THISCALL); assert( r >= 0 );
 	r = engine->RegisterObjectMethod("array<T>", "void sortAsc(uint startAt, uint count)", asMETHODPR(CScriptArray, SortAsc, (asUINT, asUINT), void), asCALL_THISCALL); assert( r >= 0 );
 	r = engine->RegisterObjectMethod("array<T>", "void sortDesc()", asMETHODPR(CScriptArray, SortDesc, (), void), asCALL_THISCALL); assert( r >= 0 );
 	r = engine->RegisterObjectMethod("array<T>", "void sortDesc(uint startAt, uint count)", asMETHODPR(CScriptArray, SortDesc, (asUINT, asUINT), void), asCALL_THISCALL); assert( r >= 0 );
+	r = engine->RegisterObjectMethod("array<T>", "void stableSortAsc()", asMETHODPR(CScriptArray, StableSortAsc, (), void), asCALL_THISCALL); assert( r >= 0 );
+	r = engine->RegisterObjectMethod("array<T>", "void stableSortAsc(uint startAt, uint count)", asMETHODPR(CScriptArray, StableSortAsc, (asUINT, asUINT), void), asCALL_THISCALL); assert( r >= 0 );
+	r = engine->RegisterObjectMethod("array<T>", "void stableSortDesc()", asMETHODPR(CScriptArray, StableSortDesc, (), void), asCALL_THISCALL); assert( r >= 0 );
+	r = engine->RegisterObjectMethod("array<T>", "void stableSortDesc(uint startAt, uint count)", asMETHODPR(CScriptArray, StableSortDesc, (asUINT, asUINT), void), asCALL_THISCALL); assert( r >= 0 );
 	r = engine->RegisterObjectMethod("array<T>", "void reverse()", asMETHOD(CScriptArray, Reverse), asCALL_THISCALL); assert( r >= 0 );
 	// The token 'if_handle_then_const' tells the engine that if the type T is a handle, then it should refer to a read-only object
 	r = engine->RegisterObjectMethod("array<T>", "int find(const T&in if_handle_then_const value) const", asMETHODPR(CScriptArray, Find, (void*) const, int), asCALL_THISCALL); assert( r >= 0 );
@@ -319,9 +710,20 @@ static void RegisterScriptArray_Native(asIScriptEngine *engine)
 	r = engine->RegisterObjectMethod("array<T>", "bool opEquals(const array<T>&in) const", asMETHOD(CScriptArray, operator==), asCALL_THISCALL); assert( r >= 0 );
 	r = engine->RegisterObjectMethod("array<T>", "bool isEmpty() const", asMETHOD(CScriptArray, IsEmpty), asCALL_THISCALL); assert( r >= 0 );
 
+	// Bulk math for arrays of numbers. The methods returning T use the generic calling
+	// convention as the native return depends on the subtype
+	r = engine->RegisterObjectMethod("array<T>", "T sum() const", asFUNCTION(ScriptArraySum_Generic), asCALL_GENERIC); assert( r >= 0 );
+	r = engine->RegisterObjectMethod("array<T>", "T min() const", asFUNCTION(ScriptArrayMin_Generic), asCALL_GENERIC); assert( r >= 0 );
+	r = engine->RegisterObjectMethod("array<T>", "T max() const", asFUNCTION(ScriptArrayMax_Generic), asCALL_GENERIC); assert( r >= 0 );
+	r = engine->RegisterObjectMethod("array<T>", "T dot(const array<T>&in) const", asFUNCTION(ScriptArrayDot_Generic), asCALL_GENERIC); assert( r >= 0 );
+	r = engine->RegisterObjectMethod("array<T>", "void scale(const T&in factor)", asMETHOD(CScriptArray, Scale), asCALL_THISCALL); assert( r >= 0 );
+	r = engine->RegisterObjectMethod("array<T>", "void add(const array<T>&in)", asMETHOD(CScriptArray, Add), asCALL_THISCALL); assert( r >= 0 );
+	r = engine->RegisterObjectMethod("array<T>", "void fill(const T&in value)", asMETHOD(CScriptArray, Fill), asCALL_THISCALL); assert( r >= 0 );
+
 	// Sort with callback for comparison
 	r = engine->RegisterFuncdef("bool array<T>::less(const T&in if_handle_then_const a, const T&in if_handle_then_const b)");
 	r = engine->RegisterObjectMethod("array<T>", "void sort(const less &in, uint startAt = 0, uint count = uint(-1))", asMETHODPR(CScriptArray, Sort, (asIScriptFunction*, asUINT, asUINT), void), asCALL_THISCALL); assert(r >= 0);
+	r = engine->RegisterObjectMethod("array<T>", "void stableSort(const less &in, uint startAt = 0, uint count = uint(-1))", asMETHOD(CScriptArray, StableSort), asCALL_THISCALL); assert(r >= 0);
 
 #if AS_USE_STLNAMES != 1 && AS_USE_ACCESSORS == 1
 	// Register virtual properties
@@ -617,11 +1019,10 @@ void CScriptArray::Reserve(asUINT maxElements)
 		return;
 
 	// Allocate memory for the buffer
-	SArrayBuffer *newBuffer = reinterpret_cast<SArrayBuffer*>(userAlloc(sizeof(SArrayBuffer)-1 + elementSize*maxElements));
+	SArrayBuffer *newBuffer = AllocBuffer(maxElements);
 	if( newBuffer )
 	{
 		newBuffer->numElements = buffer->numElements;
-		newBuffer->maxElements = maxElements;
 	}
 	else
 	{
@@ -637,7 +1038,28 @@ void CScriptArray::Reserve(asUINT maxElements)
 	memcpy(newBuffer->data, buffer->data, buffer->numElements*elementSize);
 
 	// Release the old buffer
-	userFree(buffer);
+	FreeBuffer(buffer);
+
+	buffer = newBuffer;
+}
+
+void CScriptArray::ShrinkToFit()
+{
+	if( buffer->maxElements == buffer->numElements || buffer == GetInlineBuffer() )
+		return;
+
+	// Arrays that have become small enough move back into the inline buffer
+	SArrayBuffer *newBuffer = AllocBuffer(buffer->numElements);
+	if( newBuffer == 0 )
+	{
+		// Keep the larger buffer
+		return;
+	}
+
+	newBuffer->numElements = buffer->numElements;
+	memcpy(newBuffer->data, buffer->data, buffer->numElements*elementSize);
+
+	FreeBuffer(buffer);
 
 	buffer = newBuffer;
 }
@@ -702,12 +1124,12 @@ void CScriptArray::Resize(int delta, asUINT at)
 
 	if( buffer->maxElements < buffer->numElements + delta )
 	{
-		// Allocate memory for the buffer
-		SArrayBuffer *newBuffer = reinterpret_cast<SArrayBuffer*>(userAlloc(sizeof(SArrayBuffer)-1 + elementSize*(buffer->numElements + delta)));
+		// Allocate memory for the buffer. The capacity grows geometrically so
+		// that adding one element at a time doesn't reallocate every time
+		SArrayBuffer *newBuffer = AllocBuffer(GrowCapacity(buffer->maxElements, buffer->numElements + delta));
 		if( newBuffer )
 		{
 			newBuffer->numElements = buffer->numElements + delta;
-			newBuffer->maxElements = newBuffer->numElements;
 		}
 		else
 		{
@@ -728,7 +1150,7 @@ void CScriptArray::Resize(int delta, asUINT at)
 		Construct(newBuffer, at, at+delta);
 
 		// Release the old buffer
-		userFree(buffer);
+		FreeBuffer(buffer);
 
 		buffer = newBuffer;
 	}
@@ -773,6 +1195,22 @@ bool CScriptArray::CheckMaxSize(asUINT numElements)
 	return true;
 }
 
+// internal
+// Returns the capacity to allocate for numElements, at least half again the current
+// capacity as long as that doesn't exceed the maximum size
+asUINT CScriptArray::GrowCapacity(asUINT maxElements, asUINT numElements) const
+{
+	asUINT maxSize = 0xFFFFFFFFul - sizeof(SArrayBuffer) + 1;
+	if( elementSize > 0 )
+		maxSize /= elementSize;
+
+	asUINT capacity = maxElements + maxElements/2;
+	if( capacity < maxElements || capacity > maxSize )
+		capacity = maxSize;
+
+	return capacity > numElements ? capacity : numElements;
+}
+
 asITypeInfo *CScriptArray::GetArrayObjectType() const
 {
 	return objType;
@@ -914,15 +1352,52 @@ void *CScriptArray::GetBuffer()
 }
 
 
+// internal
+SArrayBuffer *CScriptArray::GetInlineBuffer()
+{
+	return reinterpret_cast<SArrayBuffer*>(inlineBuffer);
+}
+
+// internal
+// Returns a buffer with room for at least maxElements, without any elements set. Small
+// arrays use the inline buffer when the current buffer isn't already the inline one
+SArrayBuffer *CScriptArray::AllocBuffer(asUINT maxElements)
+{
+	asUINT inlineMax = elementSize > 0 ? asUINT((sizeof(inlineBuffer) - offsetof(SArrayBuffer, data)) / elementSize) : 0;
+
+	SArrayBuffer *buf;
+	if( maxElements <= inlineMax && buffer != GetInlineBuffer() )
+	{
+		buf = GetInlineBuffer();
+		maxElements = inlineMax;
+	}
+	else
+	{
+		buf = reinterpret_cast<SArrayBuffer*>(userAlloc(sizeof(SArrayBuffer)-1+elementSize*maxElements));
+		if( buf == 0 )
+			return 0;
+	}
+
+	buf->maxElements = maxElements;
+	buf->numElements = 0;
+	return buf;
+}
+
+// internal
+void CScriptArray::FreeBuffer(SArrayBuffer *buf)
+{
+	if( buf != GetInlineBuffer() )
+		userFree(buf);
+}
+
 // internal
 void CScriptArray::CreateBuffer(SArrayBuffer **buf, asUINT numElements)
 {
-	*buf = reinterpret_cast<SArrayBuffer*>(userAlloc(sizeof(SArrayBuffer)-1+elementSize*numElements));
+	*buf = AllocBuffer(numElements);
 
 	if( *buf )
 	{
 		(*buf)->numElements = numElements;
-		(*buf)->maxElements = numElements;
 		Construct(*buf, 0, numElements);
 	}
 	else
@@ -940,7 +1415,7 @@ void CScriptArray::DeleteBuffer(SArrayBuffer *buf)
 	Destruct(buf, 0, buf->numElements);
 
 	// Free the buffer
-	userFree(buf);
+	FreeBuffer(buf);
 }
 
 // internal
@@ -1071,17 +1546,9 @@ void CScriptArray::Reverse()
 {
 	asUINT size = GetSize();
 
+	// Only the primitives or the pointers to the objects are moved
 	if( size >= 2 )
-	{
-		asBYTE TEMP[16];
-
-		for( asUINT i = 0; i < size / 2; i++ )
-		{
-			Copy(TEMP, GetArrayItemPointer(i));
-			Copy(GetArrayItemPointer(i), GetArrayItemPointer(size - i - 1));
-			Copy(GetArrayItemPointer(size - i - 1), TEMP);
-		}
-	}
+		kernels->reverse(buffer->data, size);
 }
 
 bool CScriptArray::operator==(const CScriptArray &other) const
@@ -1092,6 +1559,10 @@ bool CScriptArray::operator==(const CScriptArray &other) const
 	if( GetSize() != other.GetSize() )
 		return false;
 
+	// Primitives are compared without going through Equals for each element
+	if( !(subTypeId & ~asTYPEID_MASK_SEQNBR) )
+		return kernels->equals(buffer->data, other.buffer->data, GetSize());
+
 	asIScriptContext *cmpContext = 0;
 	bool isNested = false;
 
@@ -1236,26 +1707,26 @@ int CScriptArray::FindByRef(asUINT startAt, void *ref) const
 {
 	// Find the matching element by its reference
 	asUINT size = GetSize();
-	if( subTypeId & asTYPEID_OBJHANDLE )
-	{
-		// Dereference the pointer
-		ref = *(void**)ref;
-		for( asUINT i = startAt; i < size; i++ )
-		{
-			if( *(void**)At(i) == ref )
-				return i;
-		}
-	}
-	else
+	if( startAt >= size )
+		return -1;
+
+	if( subTypeId & asTYPEID_MASK_OBJECT )
 	{
-		// Compare the reference directly
-		for( asUINT i = startAt; i < size; i++ )
-		{
-			if( At(i) == ref )
-				return i;
-		}
+		// The buffer holds the pointers to the objects, so the
+		// pointer is searched for. A handle is dereferenced first
+		if( subTypeId & asTYPEID_OBJHANDLE )
+			ref = *(void**)ref;
+		return kernels->find(buffer->data, startAt, size, &ref);
 	}
 
+	// Primitives are stored in the buffer, so only a reference
+	// to an element itself can match
+	asPWORD address = (asPWORD)ref;
+	asPWORD first = (asPWORD)(buffer->data + startAt*elementSize);
+	asPWORD end = (asPWORD)(buffer->data + size*elementSize);
+	if( address >= first && address < end && (address - first) % elementSize == 0 )
+		return int(startAt + (address - first) / elementSize);
+
 	return -1;
 }
 
@@ -1301,32 +1772,38 @@ int CScriptArray::Find(asUINT startAt, void *value) const
 		}
 	}
 
+	asUINT size = GetSize();
+
+	// Primitives are compared without going through Equals for each element
+	if( !(subTypeId & ~asTYPEID_MASK_SEQNBR) )
+	{
+		if( startAt >= size )
+			return -1;
+		return kernels->find(buffer->data, startAt, size, value);
+	}
+
 	asIScriptContext *cmpContext = 0;
 	bool isNested = false;
 
-	if( subTypeId & ~asTYPEID_MASK_SEQNBR )
+	// Try to reuse the active context
+	cmpContext = asGetActiveContext();
+	if( cmpContext )
 	{
-		// Try to reuse the active context
-		cmpContext = asGetActiveContext();
-		if( cmpContext )
-		{
-			if( cmpContext->GetEngine() == objType->GetEngine() && cmpContext->PushState() >= 0 )
-				isNested = true;
-			else
-				cmpContext = 0;
-		}
-		if( cmpContext == 0 )
-		{
-			// TODO: Ideally this context would be retrieved from a pool, so we don't have to
-			//       create a new one everytime. We could keep a context with the array object
-			//       but that would consume a lot of resources as each context is quite heavy.
-			cmpContext = objType->GetEngine()->CreateContext();
-		}
+		if( cmpContext->GetEngine() == objType->GetEngine() && cmpContext->PushState() >= 0 )
+			isNested = true;
+		else
+			cmpContext = 0;
+	}
+	if( cmpContext == 0 )
+	{
+		// TODO: Ideally this context would be retrieved from a pool, so we don't have to
+		//       create a new one everytime. We could keep a context with the array object
+		//       but that would consume a lot of resources as each context is quite heavy.
+		cmpContext = objType->GetEngine()->CreateContext();
 	}
 
 	// Find the matching element
 	int ret = -1;
-	asUINT size = GetSize();
 
 	for( asUINT i = startAt; i < size; i++ )
 	{
@@ -1356,6 +1833,106 @@ int CScriptArray::Find(asUINT startAt, void *value) const
 
 
 
+// internal
+// Returns the math kernels, or sets a script exception if the elements aren't numbers
+static const SArrayMath *GetMath(const SArrayKernels *kernels)
+{
+	if( kernels->math == 0 )
+	{
+		asIScriptContext *ctx = asGetActiveContext();
+		if( ctx )
+			ctx->SetException("Math operations are only supported for arrays of numbers");
+	}
+	return kernels->math;
+}
+
+// internal
+static bool CheckSameSize(asUINT a, asUINT b)
+{
+	if( a != b )
+	{
+		asIScriptContext *ctx = asGetActiveContext();
+		if( ctx )
+			ctx->SetException("The arrays have different sizes");
+		return false;
+	}
+	return true;
+}
+
+// internal
+static bool CheckNotEmpty(asUINT size)
+{
+	if( size == 0 )
+	{
+		asIScriptContext *ctx = asGetActiveContext();
+		if( ctx )
+			ctx->SetException("The array is empty");
+		return false;
+	}
+	return true;
+}
+
+bool CScriptArray::Sum(void *result) const
+{
+	const SArrayMath *math = GetMath(kernels);
+	if( math == 0 )
+		return false;
+
+	math->sum(buffer->data, GetSize(), result);
+	return true;
+}
+
+bool CScriptArray::Min(void *result) const
+{
+	const SArrayMath *math = GetMath(kernels);
+	if( math == 0 || !CheckNotEmpty(GetSize()) )
+		return false;
+
+	math->min(buffer->data, GetSize(), result);
+	return true;
+}
+
+bool CScriptArray::Max(void *result) const
+{
+	const SArrayMath *math = GetMath(kernels);
+	if( math == 0 || !CheckNotEmpty(GetSize()) )
+		return false;
+
+	math->max(buffer->data, GetSize(), result);
+	return true;
+}
+
+bool CScriptArray::Dot(const CScriptArray &other, void *result) const
+{
+	const SArrayMath *math = GetMath(kernels);
+	if( math == 0 || !CheckSameSize(GetSize(), other.GetSize()) )
+		return false;
+
+	math->dot(buffer->data, other.buffer->data, GetSize(), result);
+	return true;
+}
+
+void CScriptArray::Scale(void *factor)
+{
+	const SArrayMath *math = GetMath(kernels);
+	if( math )
+		math->scale(buffer->data, GetSize(), factor);
+}
+
+void CScriptArray::Add(const CScriptArray &other)
+{
+	const SArrayMath *math = GetMath(kernels);
+	if( math && CheckSameSize(GetSize(), other.GetSize()) )
+		math->add(buffer->data, other.buffer->data, GetSize());
+}
+
+void CScriptArray::Fill(void *value)
+{
+	const SArrayMath *math = GetMath(kernels);
+	if( math )
+		math->fill(buffer->data, GetSize(), value);
+}
+
 // internal
 // Copy object handle or primitive value
 // Even in arrays of objects the objects are allocated on 
@@ -1414,9 +1991,137 @@ void CScriptArray::SortDesc(asUINT startAt, asUINT count)
 	Sort(startAt, count, false);
 }
 
+// Sort ascending, equal elements keep their order
+void CScriptArray::StableSortAsc()
+{
+	Sort(0, GetSize(), true, true);
+}
+
+// Sort ascending, equal elements keep their order
+void CScriptArray::StableSortAsc(asUINT startAt, asUINT count)
+{
+	Sort(startAt, count, true, true);
+}
+
+// Sort descending, equal elements keep their order
+void CScriptArray::StableSortDesc()
+{
+	Sort(0, GetSize(), false, true);
+}
+
+// Sort descending, equal elements keep their order
+void CScriptArray::StableSortDesc(asUINT startAt, asUINT count)
+{
+	Sort(startAt, count, false, true);
+}
+
+// internal
+// Orders the values the same way as operator <, except that NaN is placed after all
+// other values. std::sort requires a strict weak ordering to stay within the range.
+template<class T>
+struct SPrimitiveLess
+{
+	bool operator()(T a, T b) const { return a < b; }
+};
+
+template<>
+struct SPrimitiveLess<float>
+{
+	bool operator()(float a, float b) const { return a < b || (a == a && b != b); }
+};
+
+template<>
+struct SPrimitiveLess<double>
+{
+	bool operator()(double a, double b) const { return a < b || (a == a && b != b); }
+};
+
+template<class T>
+struct SPrimitiveGreater
+{
+	bool operator()(T a, T b) const { return SPrimitiveLess<T>()(b, a); }
+};
+
+// internal
+// Introsort (std::sort), or std::stable_sort if equal values must keep their order
+template<class T>
+static void SortPrimitives(void *data, asUINT count, bool asc, bool stable)
+{
+	T *first = reinterpret_cast<T*>(data);
+	T *last = first + count;
+	if( asc && stable )
+		std::stable_sort(first, last, SPrimitiveLess<T>());
+	else if( asc )
+		std::sort(first, last, SPrimitiveLess<T>());
+	else if( stable )
+		std::stable_sort(first, last, SPrimitiveGreater<T>());
+	else
+		std::sort(first, last, SPrimitiveGreater<T>());
+}
+
+// internal
+// Stable merge sort of count elements of the given size. The comparison may execute
+// script code, so it is called as few times as possible, and unlike std::stable_sort
+// the loops never depend on it being consistent to stay within the range. tmp must
+// have room for (count+1)/2 elements.
+template<class LESS>
+static void MergeSort(asBYTE *data, asUINT count, int size, asBYTE *tmp, LESS &less)
+{
+	if( count <= 8 )
+	{
+		// Insertion sort of short runs
+		for( asUINT i = 1; i < count; i++ )
+		{
+			if( !less(data + i*size, data + (i-1)*size) )
+				continue;
+
+			memcpy(tmp, data + i*size, size);
+			asUINT j = i;
+			do
+			{
+				memcpy(data + j*size, data + (j-1)*size, size);
+				j--;
+			} while( j > 0 && less(tmp, data + (j-1)*size) );
+			memcpy(data + j*size, tmp, size);
+		}
+		return;
+	}
+
+	asUINT half = count / 2;
+	asBYTE *right = data + half*size;
+	MergeSort(data, half, size, tmp, less);
+	MergeSort(right, count - half, size, tmp, less);
+
+	// The halves are already in order
+	if( !less(right, right - size) )
+		return;
+
+	// Move the left half out of the way and merge it with the right half. The
+	// output never overtakes the right half, and what remains of it is in place.
+	memcpy(tmp, data, half*size);
+	asBYTE *l = tmp, *lEnd = tmp + half*size;
+	asBYTE *r = right, *rEnd = data + count*size;
+	asBYTE *out = data;
+	while( l < lEnd && r < rEnd )
+	{
+		if( less(r, l) )
+		{
+			memcpy(out, r, size);
+			r += size;
+		}
+		else
+		{
+			memcpy(out, l, size);
+			l += size;
+		}
+		out += size;
+	}
+	memcpy(out, l, lEnd - l);
+}
+
 
 // internal
-void CScriptArray::Sort(asUINT startAt, asUINT count, bool asc)
+void CScriptArray::Sort(asUINT startAt, asUINT count, bool asc, bool stable)
 {
 	// Subtype isn't primitive and doesn't have opCmp
 	SArrayCache *cache = reinterpret_cast<SArrayCache*>(objType->GetUserData(ARRAY_CACHE));
@@ -1475,42 +2180,72 @@ void CScriptArray::Sort(asUINT startAt, asUINT count, bool asc)
 		return;
 	}
 
-	asBYTE tmp[16];
-	asIScriptContext *cmpContext = 0;
-	bool isNested = false;
-
-	if( subTypeId & ~asTYPEID_MASK_SEQNBR )
+	if( !(subTypeId & ~asTYPEID_MASK_SEQNBR) )
 	{
-		// Try to reuse the active context
-		cmpContext = asGetActiveContext();
-		if( cmpContext )
-		{
-			if( cmpContext->GetEngine() == objType->GetEngine() && cmpContext->PushState() >= 0 )
-				isNested = true;
-			else
-				cmpContext = 0;
-		}
-		if( cmpContext == 0 )
+		// Primitives are compared directly, so they are sorted in place
+		void *data = GetArrayItemPointer(start);
+		switch( subTypeId )
 		{
-			cmpContext = objType->GetEngine()->RequestContext();
+		case asTYPEID_BOOL:   SortPrimitives<bool>(data, count, asc, stable); break;
+		case asTYPEID_INT8:   SortPrimitives<signed char>(data, count, asc, stable); break;
+		case asTYPEID_UINT8:  SortPrimitives<unsigned char>(data, count, asc, stable); break;
+		case asTYPEID_INT16:  SortPrimitives<signed short>(data, count, asc, stable); break;
+		case asTYPEID_UINT16: SortPrimitives<unsigned short>(data, count, asc, stable); break;
+		case asTYPEID_INT32:  SortPrimitives<signed int>(data, count, asc, stable); break;
+		case asTYPEID_UINT32: SortPrimitives<unsigned int>(data, count, asc, stable); break;
+		case asTYPEID_INT64:  SortPrimitives<asINT64>(data, count, asc, stable); break;
+		case asTYPEID_UINT64: SortPrimitives<asQWORD>(data, count, asc, stable); break;
+		case asTYPEID_FLOAT:  SortPrimitives<float>(data, count, asc, stable); break;
+		case asTYPEID_DOUBLE: SortPrimitives<double>(data, count, asc, stable); break;
+		default:              SortPrimitives<signed int>(data, count, asc, stable); break; // All enums fall in this case
 		}
+		return;
 	}
 
-	// Insertion sort
-	for( int i = start + 1; i < end; i++ )
+	// The merge sort needs room for half of the elements
+	asBYTE *tmp = reinterpret_cast<asBYTE*>(userAlloc(((count + 1) / 2) * elementSize));
+	if( tmp == 0 )
 	{
-		Copy(tmp, GetArrayItemPointer(i));
+		asIScriptContext *ctx = asGetActiveContext();
+		if( ctx )
+			ctx->SetException("Out of memory");
 
-		int j = i - 1;
+		return;
+	}
 
-		while( j >= start && Less(GetDataPointer(tmp), At(j), asc, cmpContext, cache) )
-		{
-			Copy(GetArrayItemPointer(j + 1), GetArrayItemPointer(j));
-			j--;
-		}
+	asIScriptContext *cmpContext = 0;
+	bool isNested = false;
 
-		Copy(GetArrayItemPointer(j + 1), tmp);
+	// Try to reuse the active context
+	cmpContext = asGetActiveContext();
+	if( cmpContext )
+	{
+		if( cmpContext->GetEngine() == objType->GetEngine() && cmpContext->PushState() >= 0 )
+			isNested = true;
+		else
+			cmpContext = 0;
 	}
+	if( cmpContext == 0 )
+	{
+		cmpContext = objType->GetEngine()->RequestContext();
+	}
+
+	// Objects are always sorted with the stable merge sort, as it needs the fewest calls
+	// to opCmp. Once opCmp fails the remaining elements are merged without calling it.
+	bool failed = false;
+	auto less = [&](asBYTE *a, asBYTE *b)
+	{
+		if( failed )
+			return false;
+
+		bool isLess = Less(GetDataPointer(a), GetDataPointer(b), asc, cmpContext, cache);
+		asEContextState state = cmpContext->GetState();
+		if( state == asEXECUTION_EXCEPTION || state == asEXECUTION_ABORTED )
+			failed = true;
+		return isLess;
+	};
+	MergeSort(reinterpret_cast<asBYTE*>(GetArrayItemPointer(start)), count, elementSize, tmp, less);
+	userFree(tmp);
 
 	if( cmpContext )
 	{
@@ -1550,7 +2285,20 @@ void CScriptArray::Sort(asIScriptFunction *func, asUINT startAt, asUINT count)
 		return;
 	}
 
-	asBYTE tmp[16];
+	if (end - start < 2)
+		return;
+
+	// The merge sort needs room for half of the elements
+	asBYTE *tmp = reinterpret_cast<asBYTE*>(userAlloc(((end - start + 1) / 2) * elementSize));
+	if (tmp == 0)
+	{
+		asIScriptContext *ctx = asGetActiveContext();
+		if (ctx)
+			ctx->SetException("Out of memory");
+
+		return;
+	}
+
 	asIScriptContext *cmpContext = 0;
 	bool isNested = false;
 
@@ -1566,32 +2314,26 @@ void CScriptArray::Sort(asIScriptFunction *func, asUINT startAt, asUINT count)
 	if (cmpContext == 0)
 		cmpContext = objType->GetEngine()->RequestContext();
 
-	// Insertion sort
-	for (asUINT i = start + 1; i < end; i++)
+	// Stable merge sort. Once the callback fails the remaining elements are merged without calling it.
+	bool failed = false;
+	auto less = [&](asBYTE *a, asBYTE *b)
 	{
-		Copy(tmp, GetArrayItemPointer(i));
-
-		asUINT j = i - 1;
+		if (failed)
+			return false;
 
-		while (j != 0xFFFFFFFF && j >= start )
+		cmpContext->Prepare(func);
+		cmpContext->SetArgAddress(0, GetDataPointer(a));
+		cmpContext->SetArgAddress(1, GetDataPointer(b));
+		int r = cmpContext->Execute();
+		if (r != asEXECUTION_FINISHED)
 		{
-			cmpContext->Prepare(func);
-			cmpContext->SetArgAddress(0, GetDataPointer(tmp));
-			cmpContext->SetArgAddress(1, At(j));
-			int r = cmpContext->Execute();
-			if (r != asEXECUTION_FINISHED)
-				break;
-			if (*(bool*)(cmpContext->GetAddressOfReturnValue()))
-			{
-				Copy(GetArrayItemPointer(j + 1), GetArrayItemPointer(j));
-				j--;
-			}
-			else
-				break;
+			failed = true;
+			return false;
 		}
-
-		Copy(GetArrayItemPointer(j + 1), tmp);
-	}
+		return *(bool*)(cmpContext->GetAddressOfReturnValue());
+	};
+	MergeSort(reinterpret_cast<asBYTE*>(GetArrayItemPointer(start)), end - start, elementSize, tmp, less);
+	userFree(tmp);
 
 	if (cmpContext)
 	{
@@ -1607,6 +2349,12 @@ void CScriptArray::Sort(asIScriptFunction *func, asUINT startAt, asUINT count)
 	}
 }
 
+// Same as Sort, which is stable as well, but guarantees that it stays stable
+void CScriptArray::StableSort(asIScriptFunction *func, asUINT startAt, asUINT count)
+{
+	Sort(func, startAt, count);
+}
+
 // internal
 void CScriptArray::CopyBuffer(SArrayBuffer *dst, SArrayBuffer *src)
 {
@@ -1665,6 +2413,9 @@ void CScriptArray::Precache()
 {
 	subTypeId = objType->GetSubTypeId();
 
+	// The kernels only depend on the subtype
+	kernels = GetArrayKernels(subTypeId);
+
 	// Check if it is an array of objects. Only for these do we need to cache anything
 	// Type ids for primitives and enums only has the sequence number part
 	if( !(subTypeId & ~asTYPEID_MASK_SEQNBR) )
@@ -2026,6 +2777,12 @@ static void ScriptArrayReserve_Generic(asIScriptGeneric *gen)
 	self->Reserve(size);
 }
 
+static void ScriptArrayShrinkToFit_Generic(asIScriptGeneric *gen)
+{
+	CScriptArray *self = (CScriptArray*)gen->GetObject();
+	self->ShrinkToFit();
+}
+
 static void ScriptArraySortAsc_Generic(asIScriptGeneric *gen)
 {
 	CScriptArray *self = (CScriptArray*)gen->GetObject();
@@ -2075,6 +2832,89 @@ static void ScriptArraySortCallback_Generic(asIScriptGeneric *gen)
 	self->Sort(callback, startAt, count);
 }
 
+static void ScriptArraySum_Generic(asIScriptGeneric *gen)
+{
+	CScriptArray *self = (CScriptArray*)gen->GetObject();
+	self->Sum(gen->GetAddressOfReturnLocation());
+}
+
+static void ScriptArrayMin_Generic(asIScriptGeneric *gen)
+{
+	CScriptArray *self = (CScriptArray*)gen->GetObject();
+	self->Min(gen->GetAddressOfReturnLocation());
+}
+
+static void ScriptArrayMax_Generic(asIScriptGeneric *gen)
+{
+	CScriptArray *self = (CScriptArray*)gen->GetObject();
+	self->Max(gen->GetAddressOfReturnLocation());
+}
+
+static void ScriptArrayDot_Generic(asIScriptGeneric *gen)
+{
+	CScriptArray *other = (CScriptArray*)gen->GetArgObject(0);
+	CScriptArray *self = (CScriptArray*)gen->GetObject();
+	self->Dot(*other, gen->GetAddressOfReturnLocation());
+}
+
+static void ScriptArrayScale_Generic(asIScriptGeneric *gen)
+{
+	void *factor = gen->GetArgAddress(0);
+	CScriptArray *self = (CScriptArray*)gen->GetObject();
+	self->Scale(factor);
+}
+
+static void ScriptArrayAdd_Generic(asIScriptGeneric *gen)
+{
+	CScriptArray *other = (CScriptArray*)gen->GetArgObject(0);
+	CScriptArray *self = (CScriptArray*)gen->GetObject();
+	self->Add(*other);
+}
+
+static void ScriptArrayFill_Generic(asIScriptGeneric *gen)
+{
+	void *value = gen->GetArgAddress(0);
+	CScriptArray *self = (CScriptArray*)gen->GetObject();
+	self->Fill(value);
+}
+
+static void ScriptArrayStableSortAsc_Generic(asIScriptGeneric *gen)
+{
+	CScriptArray *self = (CScriptArray*)gen->GetObject();
+	self->StableSortAsc();
+}
+
+static void ScriptArrayStableSortAsc2_Generic(asIScriptGeneric *gen)
+{
+	asUINT index = gen->GetArgDWord(0);
+	asUINT count = gen->GetArgDWord(1);
+	CScriptArray *self = (CScriptArray*)gen->GetObject();
+	self->StableSortAsc(index, count);
+}
+
+static void ScriptArrayStableSortDesc_Generic(asIScriptGeneric *gen)
+{
+	CScriptArray *self = (CScriptArray*)gen->GetObject();
+	self->StableSortDesc();
+}
+
+static void ScriptArrayStableSortDesc2_Generic(asIScriptGeneric *gen)
+{
+	asUINT index = gen->GetArgDWord(0);
+	asUINT count = gen->GetArgDWord(1);
+	CScriptArray *self = (CScriptArray*)gen->GetObject();
+	self->StableSortDesc(index, count);
+}
+
+static void ScriptArrayStableSortCallback_Generic(asIScriptGeneric *gen)
+{
+	asIScriptFunction *callback = (asIScriptFunction*)gen->GetArgAddress(0);
+	asUINT startAt = gen->GetArgDWord(1);
+	asUINT count = gen->GetArgDWord(2);
+	CScriptArray *self = (CScriptArray*)gen->GetObject();
+	self->StableSort(callback, startAt, count);
+}
+
 static void ScriptArrayAddRef_Generic(asIScriptGeneric *gen)
 {
 	CScriptArray *self = (CScriptArray*)gen->GetObject();
@@ -2150,10 +2990,15 @@ static void RegisterScriptArray_Generic(asIScriptEngine *engine)
 #endif
 	r = engine->RegisterObjectMethod("array<T>", "void reserve(uint length)", asFUNCTION(ScriptArrayReserve_Generic), asCALL_GENERIC); assert( r >= 0 );
 	r = engine->RegisterObjectMethod("array<T>", "void resize(uint length)", asFUNCTION(ScriptArrayResize_Generic), asCALL_GENERIC); assert( r >= 0 );
+	r = engine->RegisterObjectMethod("array<T>", "void shrinkToFit()", asFUNCTION(ScriptArrayShrinkToFit_Generic), asCALL_GENERIC); assert( r >= 0 );
 	r = engine->RegisterObjectMethod("array<T>", "void sortAsc()", asFUNCTION(ScriptArraySortAsc_Generic), asCALL_GENERIC); assert( r >= 0 );
 	r = engine->RegisterObjectMethod("array<T>", "void sortAsc(uint startAt, uint count)", asFUNCTION(ScriptArraySortAsc2_Generic), asCALL_GENERIC); assert( r >= 0 );
 	r = engine->RegisterObjectMethod("array<T>", "void sortDesc()", asFUNCTION(ScriptArraySortDesc_Generic), asCALL_GENERIC); assert( r >= 0 );
 	r = engine->RegisterObjectMethod("array<T>", "void sortDesc(uint startAt, uint count)", asFUNCTION(ScriptArraySortDesc2_Generic), asCALL_GENERIC); assert( r >= 0 );
+	r = engine->RegisterObjectMethod("array<T>", "void stableSortAsc()", asFUNCTION(ScriptArrayStableSortAsc_Generic), asCALL_GENERIC); assert( r >= 0 );
+	r = engine->RegisterObjectMethod("array<T>", "void stableSortAsc(uint startAt, uint count)", asFUNCTION(ScriptArrayStableSortAsc2_Generic), asCALL_GENERIC); assert( r >= 0 );
+	r = engine->RegisterObjectMethod("array<T>", "void stableSortDesc()", asFUNCTION(ScriptArrayStableSortDesc_Generic), asCALL_GENERIC); assert( r >= 0 );
+	r = engine->RegisterObjectMethod("array<T>", "void stableSortDesc(uint startAt, uint count)", asFUNCTION(ScriptArrayStableSortDesc2_Generic), asCALL_GENERIC); assert( r >= 0 );
 	r = engine->RegisterObjectMethod("array<T>", "void reverse()", asFUNCTION(ScriptArrayReverse_Generic), asCALL_GENERIC); assert( r >= 0 );
 	r = engine->RegisterObjectMethod("array<T>", "int find(const T&in if_handle_then_const value) const", asFUNCTION(ScriptArrayFind_Generic), asCALL_GENERIC); assert( r >= 0 );
 	r = engine->RegisterObjectMethod("array<T>", "int find(uint startAt, const T&in if_handle_then_const value) const", asFUNCTION(ScriptArrayFind2_Generic), asCALL_GENERIC); assert( r >= 0 );
@@ -2161,8 +3006,16 @@ static void RegisterScriptArray_Generic(asIScriptEngine *engine)
 	r = engine->RegisterObjectMethod("array<T>", "int findByRef(uint startAt, const T&in if_handle_then_const value) const", asFUNCTION(ScriptArrayFindByRef2_Generic), asCALL_GENERIC); assert( r >= 0 );
 	r = engine->RegisterObjectMethod("array<T>", "bool opEquals(const array<T>&in) const", asFUNCTION(ScriptArrayEquals_Generic), asCALL_GENERIC); assert( r >= 0 );
 	r = engine->RegisterObjectMethod("array<T>", "bool isEmpty() const", asFUNCTION(ScriptArrayIsEmpty_Generic), asCALL_GENERIC); assert( r >= 0 );
+	r = engine->RegisterObjectMethod("array<T>", "T sum() const", asFUNCTION(ScriptArraySum_Generic), asCALL_GENERIC); assert( r >= 0 );
+	r = engine->RegisterObjectMethod("array<T>", "T min() const", asFUNCTION(ScriptArrayMin_Generic), asCALL_GENERIC); assert( r >= 0 );
+	r = engine->RegisterObjectMethod("array<T>", "T max() const", asFUNCTION(ScriptArrayMax_Generic), asCALL_GENERIC); assert( r >= 0 );
+	r = engine->RegisterObjectMethod("array<T>", "T dot(const array<T>&in) const", asFUNCTION(ScriptArrayDot_Generic), asCALL_GENERIC); assert( r >= 0 );
+	r = engine->RegisterObjectMethod("array<T>", "void scale(const T&in factor)", asFUNCTION(ScriptArrayScale_Generic), asCALL_GENERIC); assert( r >= 0 );
+	r = engine->RegisterObjectMethod("array<T>", "void add(const array<T>&in)", asFUNCTION(ScriptArrayAdd_Generic), asCALL_GENERIC); assert( r >= 0 );
+	r = engine->RegisterObjectMethod("array<T>", "void fill(const T&in value)", asFUNCTION(ScriptArrayFill_Generic), asCALL_GENERIC); assert( r >= 0 );
 	r = engine->RegisterFuncdef("bool array<T>::less(const T&in a, const T&in b)");
 	r = engine->RegisterObjectMethod("array<T>", "void sort(const less &in, uint startAt = 0, uint count = uint(-1))", asFUNCTION(ScriptArraySortCallback_Generic), asCALL_GENERIC); assert(r >= 0);
+	r = engine->RegisterObjectMethod("array<T>", "void stableSort(const less &in, uint startAt = 0, uint count = uint(-1))", asFUNCTION(ScriptArrayStableSortCallback_Generic), asCALL_GENERIC); assert(r >= 0);
 #if AS_USE_STLNAMES != 1 && AS_USE_ACCESSORS == 1
 	r = engine->RegisterObjectMethod("array<T>", "uint get_length() const property", asFUNCTION(ScriptArrayLength_Generic), asCALL_GENERIC); assert( r >= 0 );
 	r = engine->RegisterObjectMethod("array<T>", "void set_length(uint) property", asFUNCTION(ScriptArrayResize_Generic), asCALL_GENERIC); assert( r >= 0 );
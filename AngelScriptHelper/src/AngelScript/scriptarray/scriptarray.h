@@ -22,10 +22,17 @@
 #define AS_USE_ACCESSORS 0
 #endif
 
+// Arrays whose elements fit in this many bytes store them inside the array object
+// instead of allocating a separate buffer. Empty arrays never allocate a buffer.
+#ifndef AS_ARRAY_INLINE_BYTES
+#define AS_ARRAY_INLINE_BYTES 32
+#endif
+
 BEGIN_AS_NAMESPACE
 
 struct SArrayBuffer;
 struct SArrayCache;
+struct SArrayKernels;
 
 class CScriptArray
 {
@@ -60,6 +67,9 @@ public:
 	// Resize the array
 	void   Resize(asUINT numElements);
 
+	// Releases the memory that was reserved for more elements than the array holds
+	void   ShrinkToFit();
+
 	// Get a pointer to an element. Returns 0 if out of bounds
 	void       *At(asUINT index);
 	const void *At(asUINT index) const;
@@ -87,14 +97,32 @@ public:
 	void SortDesc();
 	void SortAsc(asUINT startAt, asUINT count);
 	void SortDesc(asUINT startAt, asUINT count);
-	void Sort(asUINT startAt, asUINT count, bool asc);
+	void Sort(asUINT startAt, asUINT count, bool asc, bool stable = false);
 	void Sort(asIScriptFunction *less, asUINT startAt, asUINT count);
+	// Same as above, but equal elements are guaranteed to keep their order
+	void StableSortAsc();
+	void StableSortDesc();
+	void StableSortAsc(asUINT startAt, asUINT count);
+	void StableSortDesc(asUINT startAt, asUINT count);
+	void StableSort(asIScriptFunction *less, asUINT startAt, asUINT count);
 	void Reverse();
 	int  Find(void *value) const;
 	int  Find(asUINT startAt, void *value) const;
 	int  FindByRef(void *ref) const;
 	int  FindByRef(asUINT startAt, void *ref) const;
 
+	// Bulk math for arrays of numbers, a script exception is set for other subtypes such as
+	// bool, enums and objects. The methods are registered for every array<T>, so scripts only
+	// find out at run time. The values and results are passed by address and have the type
+	// of the elements. Integers wrap around on overflow
+	bool Sum(void *result) const;
+	bool Min(void *result) const;
+	bool Max(void *result) const;
+	bool Dot(const CScriptArray &other, void *result) const;
+	void Scale(void *factor);
+	void Add(const CScriptArray &other);
+	void Fill(void *value);
+
 	// Return the address of internal buffer for direct manipulation of elements
 	void *GetBuffer();
 
@@ -112,6 +140,10 @@ protected:
 	SArrayBuffer   *buffer;
 	int             elementSize;
 	int             subTypeId;
+	const SArrayKernels *kernels;
+
+	// Storage for the SArrayBuffer of small arrays, the header takes the first 8 bytes
+	asQWORD         inlineBuffer[1 + (AS_ARRAY_INLINE_BYTES + 7) / 8];
 
 	// Constructors
 	CScriptArray(asITypeInfo *ot, void *initBuf); // Called from script when initialized with list
@@ -126,7 +158,11 @@ protected:
 	void  Copy(void *dst, void *src);
 	void  Precache();
 	bool  CheckMaxSize(asUINT numElements);
+	asUINT GrowCapacity(asUINT maxElements, asUINT numElements) const;
 	void  Resize(int delta, asUINT at);
+	SArrayBuffer *GetInlineBuffer();
+	SArrayBuffer *AllocBuffer(asUINT maxElements);
+	void  FreeBuffer(SArrayBuffer *buf);
 	void  CreateBuffer(SArrayBuffer **buf, asUINT numElements);
 	void  DeleteBuffer(SArrayBuffer *buf);
 	void  CopyBuffer(SArrayBuffer *dst, SArrayBuffer *src);
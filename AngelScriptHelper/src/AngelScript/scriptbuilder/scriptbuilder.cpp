@@ -88,6 +88,33 @@ string CScriptBuilder::GetSectionName(unsigned int idx) const
 	return *it;
 }
 
+const map<string, asQWORD> &CScriptBuilder::GetSectionHashes() const
+{
+	return sectionHashes;
+}
+
+const set<string> &CScriptBuilder::GetMissingFiles() const
+{
+	return missingFiles;
+}
+
+// 64bit FNV-1a
+asQWORD CScriptBuilder::HashSection(const char *data, size_t length)
+{
+	asQWORD hash = 14695981039346656037ULL;
+	for( size_t n = 0; n < length; n++ )
+	{
+		hash ^= (unsigned char)data[n];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+string CScriptBuilder::GetSectionNameForFile(const char *filename)
+{
+	return GetAbsolutePath(filename);
+}
+
 // Returns 1 if the section was included
 // Returns 0 if the section was not included because it had already been included before
 // Returns <0 if there was an error
@@ -143,6 +170,8 @@ void CScriptBuilder::DefineWord(const char *word)
 void CScriptBuilder::ClearAll()
 {
 	includedScripts.clear();
+	sectionHashes.clear();
+	missingFiles.clear();
 
 #if AS_PROCESS_METADATA == 1
 	currentClass = "";
@@ -185,6 +214,7 @@ int CScriptBuilder::LoadScriptSection(const char *filename)
 		// Write a message to the engine's message callback
 		string msg = "Failed to open script file '" + GetAbsolutePath(scriptFile) + "'";
 		engine->WriteMessage(filename, 0, 0, asMSGTYPE_ERROR, msg.c_str());
+		missingFiles.insert(GetAbsolutePath(scriptFile));
 
 		// TODO: Write the file where this one was included from
 
@@ -232,6 +262,9 @@ int CScriptBuilder::ProcessScriptSection(const char *script, unsigned int length
 	else
 		modifiedScript = script;
 
+	// Remember what the section looked like before it was modified
+	sectionHashes[sectionname] = HashSection(modifiedScript.c_str(), modifiedScript.size());
+
 	// First perform the checks for #if directives to exclude code that shouldn't be compiled
 	unsigned int pos = 0;
 	int nested = 0;
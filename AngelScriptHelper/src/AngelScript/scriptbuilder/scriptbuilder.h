@@ -99,6 +99,22 @@ public:
 	unsigned int GetSectionCount() const;
 	std::string  GetSectionName(unsigned int idx) const;
 
+	// Content hash of every section processed since StartNewModule, keyed by
+	// section name. Includes the sections added through the include callback,
+	// so it can be used to tell if a module needs to be rebuilt at all.
+	const std::map<std::string, asQWORD> &GetSectionHashes() const;
+
+	// Files that couldn't be opened since StartNewModule, e.g. includes that don't
+	// exist yet. Together with the section hashes this tells when to rebuild.
+	const std::set<std::string> &GetMissingFiles() const;
+
+	// The hash function used for the section hashes
+	static asQWORD HashSection(const char *data, size_t length);
+
+	// The section name AddSectionFromFile would use for the file, this lets an include
+	// callback add a file it already has in memory without it being included twice
+	static std::string GetSectionNameForFile(const char *filename);
+
 #if AS_PROCESS_METADATA == 1
 	// Get metadata declared for classes, interfaces, and enums
 	std::vector<std::string> GetMetadataForType(int typeId);
@@ -209,6 +225,8 @@ protected:
 #endif
 
 	std::set<std::string>      definedWords;
+	std::map<std::string, asQWORD> sectionHashes;
+	std::set<std::string>      missingFiles;
 };
 
 END_AS_NAMESPACE
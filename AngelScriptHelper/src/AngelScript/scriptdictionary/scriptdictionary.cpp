@@ -15,6 +15,15 @@ using namespace std;
 // through 1999 for this purpose, so we should be fine.
 const asPWORD DICTIONARY_CACHE = 1003;
 
+// Use the pooled allocator by default, or the angelscript engine's memory routines
+#if AS_USE_SCRIPTPOOL
+static asALLOCFUNC_t userAlloc = ScriptPoolAlloc;
+static asFREEFUNC_t  userFree  = ScriptPoolFree;
+#else
+static asALLOCFUNC_t userAlloc = asAllocMem;
+static asFREEFUNC_t  userFree  = asFreeMem;
+#endif
+
 // This cache holds the object type of the dictionary type and array type
 // so it isn't necessary to look this up each time the dictionary or array
 // is created.
@@ -54,16 +63,16 @@ struct SDictionaryCache
 
 CScriptDictionary *CScriptDictionary::Create(asIScriptEngine *engine)
 {
-	// Use the custom memory routine from AngelScript to allow application to better control how much memory is used
-	CScriptDictionary *obj = (CScriptDictionary*)asAllocMem(sizeof(CScriptDictionary));
+	// Use the pool or the custom memory routine from AngelScript to allow application to better control how much memory is used
+	CScriptDictionary *obj = (CScriptDictionary*)userAlloc(sizeof(CScriptDictionary));
 	new(obj) CScriptDictionary(engine);
 	return obj;
 }
 
 CScriptDictionary *CScriptDictionary::Create(asBYTE *buffer)
 {
-	// Use the custom memory routine from AngelScript to allow application to better control how much memory is used
-	CScriptDictionary *obj = (CScriptDictionary*)asAllocMem(sizeof(CScriptDictionary));
+	// Use the pool or the custom memory routine from AngelScript to allow application to better control how much memory is used
+	CScriptDictionary *obj = (CScriptDictionary*)userAlloc(sizeof(CScriptDictionary));
 	new(obj) CScriptDictionary(buffer);
 	return obj;
 }
@@ -211,7 +220,7 @@ void CScriptDictionary::Release() const
 	if( asAtomicDec(refCount) == 0 )
 	{
 		this->~CScriptDictionary();
-		asFreeMem(const_cast<CScriptDictionary*>(this));
+		userFree(const_cast<CScriptDictionary*>(this));
 	}
 }
 
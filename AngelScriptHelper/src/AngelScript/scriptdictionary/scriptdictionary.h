@@ -24,13 +24,19 @@ END_AS_NAMESPACE
 // C++11 introduced the std::unordered_map which is a hash map which is
 // is generally more performatic for lookups than the std::map which is a 
 // binary tree.
-// TODO: memory: The map allocator should use the asAllocMem and asFreeMem
+// The nodes of the map are allocated from the pool, unless AS_USE_SCRIPTPOOL is 0
+#include "../scriptpool/scriptpool.h"
+#if AS_USE_SCRIPTPOOL
+typedef AS_NAMESPACE_QUALIFIER CScriptPoolAllocator<std::pair<const dictKey_t, AS_NAMESPACE_QUALIFIER CScriptDictValue> > dictAllocator_t;
+#else
+typedef std::allocator<std::pair<const dictKey_t, AS_NAMESPACE_QUALIFIER CScriptDictValue> > dictAllocator_t;
+#endif
 #if AS_CAN_USE_CPP11
 #include <unordered_map>
-typedef std::unordered_map<dictKey_t, AS_NAMESPACE_QUALIFIER CScriptDictValue> dictMap_t;
+typedef std::unordered_map<dictKey_t, AS_NAMESPACE_QUALIFIER CScriptDictValue, std::hash<dictKey_t>, std::equal_to<dictKey_t>, dictAllocator_t> dictMap_t;
 #else
 #include <map>
-typedef std::map<dictKey_t, AS_NAMESPACE_QUALIFIER CScriptDictValue> dictMap_t;
+typedef std::map<dictKey_t, AS_NAMESPACE_QUALIFIER CScriptDictValue, std::less<dictKey_t>, dictAllocator_t> dictMap_t;
 #endif
 
 
@@ -204,7 +210,7 @@ public:
 	void ReleaseAllReferences(asIScriptEngine *engine);
 
 protected:
-	// Since the dictionary uses the asAllocMem and asFreeMem functions to allocate memory
+	// Since the dictionary uses the pool or the asAllocMem and asFreeMem functions to allocate memory
 	// the constructors are made protected so that the application cannot allocate it 
 	// manually in a different way
 	CScriptDictionary(asIScriptEngine *engine);
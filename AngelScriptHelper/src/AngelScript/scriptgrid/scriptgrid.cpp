@@ -5,15 +5,21 @@
 #include <stdio.h> // sprintf
 
 #include "scriptgrid.h"
+#include "../scriptpool/scriptpool.h"
 
 using namespace std;
 
 BEGIN_AS_NAMESPACE
 
 // Set the default memory routines
-// Use the angelscript engine's memory routines by default
+// Use the pooled allocator by default, or the angelscript engine's memory routines
+#if AS_USE_SCRIPTPOOL
+static asALLOCFUNC_t userAlloc = ScriptPoolAlloc;
+static asFREEFUNC_t  userFree  = ScriptPoolFree;
+#else
 static asALLOCFUNC_t userAlloc = asAllocMem;
 static asFREEFUNC_t  userFree  = asFreeMem;
+#endif
 
 // Allows the application to set which memory routines should be used by the array object
 void CScriptGrid::SetMemoryFunctions(asALLOCFUNC_t allocFunc, asFREEFUNC_t freeFunc)
@@ -0,0 +1,349 @@
+#include <assert.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+
+#include "scriptpool.h"
+
+BEGIN_AS_NAMESPACE
+
+// Every allocation starts with a header telling which size class it belongs
+// to, as the free function isn't given the size. It is 16 bytes so that the
+// allocations keep the alignment of malloc
+struct SPoolHeader
+{
+	asUINT  sizeClass;
+	asUINT  padding;
+	asQWORD size; // Only set for large allocations
+};
+
+// Free blocks are linked through their first bytes
+struct SPoolBlock
+{
+	SPoolBlock *next;
+};
+
+// Block sizes of the classes, including the header. They are closer together
+// for the small sizes, where most of the containers and their buffers are
+static const asUINT classSizes[] = { 32, 48, 64, 80, 96, 112, 128, 160, 192, 256, 320, 384, 512, 768, 1024, 1536, 2048 };
+static const asUINT NUM_CLASSES  = sizeof(classSizes) / sizeof(classSizes[0]);
+static const asUINT LARGE_CLASS  = asUINT(-1);
+
+// Size of the chunks the blocks are carved from
+static const asUINT CHUNK_SIZE   = 64 * 1024;
+
+// Number of blocks a thread takes from the shared free lists at a time
+static const asUINT REFILL_COUNT = 16;
+
+// When a thread has more free blocks of a class than this, half of them are
+// given back to the shared free lists for the other threads to use
+static const asUINT MAX_CACHED   = 64;
+
+// The free blocks of each thread. The counters are only written by the owning
+// thread, they are atomic so that GetScriptPoolStats can read them
+struct SPoolThreadCache
+{
+	SPoolBlock *freeList[NUM_CLASSES];
+	asUINT      count[NUM_CLASSES];
+	bool        registered;
+	bool        exited;
+
+	std::atomic<asQWORD> allocations;
+	std::atomic<asQWORD> frees;
+	std::atomic<asQWORD> largeAllocations;
+	std::atomic<asQWORD> cacheMisses;
+	std::atomic<asQWORD> bytesInUse; // Wraps around when blocks are freed by another thread, the sum is still right
+
+	SPoolThreadCache *next;
+	SPoolThreadCache *prev;
+};
+
+// The cache is trivially destructible, so it stays usable while the other
+// thread local objects are destroyed. This object gives it back on thread exit
+struct SPoolThreadExit
+{
+	~SPoolThreadExit();
+};
+
+static thread_local SPoolThreadCache threadCache;
+static thread_local SPoolThreadExit  threadExit;
+
+// Shared state, all protected by the lock
+static std::mutex        poolLock;
+static SPoolBlock       *sharedFreeList[NUM_CLASSES];
+static SPoolBlock       *chunks;
+static SPoolThreadCache *threads;
+static SScriptPoolStats  exitedStats; // Counters of the threads that have exited
+
+// internal
+static asUINT GetSizeClass(size_t size)
+{
+	size += sizeof(SPoolHeader);
+	for( asUINT n = 0; n < NUM_CLASSES; n++ )
+		if( size <= classSizes[n] )
+			return n;
+	return LARGE_CLASS;
+}
+
+// internal
+// Only called by the owning thread
+static inline void AddCount(std::atomic<asQWORD> &counter, asQWORD n)
+{
+	counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+// internal
+// The lock must be held. Returns a free block from the shared list, allocating a new chunk if needed
+static SPoolBlock *PopShared(asUINT sizeClass)
+{
+	if( sharedFreeList[sizeClass] == 0 )
+	{
+		SPoolBlock *chunk = reinterpret_cast<SPoolBlock*>(asAllocMem(CHUNK_SIZE));
+		if( chunk == 0 )
+			return 0;
+
+		chunk->next = chunks;
+		chunks = chunk;
+		exitedStats.bytesReserved += CHUNK_SIZE;
+
+		// The first bytes are kept for the link to the next chunk, with the size
+		// of the header so that the blocks are aligned the same way
+		asBYTE *first = reinterpret_cast<asBYTE*>(chunk) + sizeof(SPoolHeader);
+		asBYTE *end   = reinterpret_cast<asBYTE*>(chunk) + CHUNK_SIZE;
+		asUINT  size  = classSizes[sizeClass];
+		for( asBYTE *p = first; p + size <= end; p += size )
+		{
+			SPoolBlock *block = reinterpret_cast<SPoolBlock*>(p);
+			block->next = sharedFreeList[sizeClass];
+			sharedFreeList[sizeClass] = block;
+		}
+	}
+
+	SPoolBlock *block = sharedFreeList[sizeClass];
+	sharedFreeList[sizeClass] = block->next;
+	return block;
+}
+
+// internal
+// The lock must be held
+static void PushShared(SPoolBlock *block, asUINT sizeClass)
+{
+	block->next = sharedFreeList[sizeClass];
+	sharedFreeList[sizeClass] = block;
+}
+
+// internal
+static void RegisterThread(SPoolThreadCache &cache)
+{
+	// Make sure the cache is given back when the thread exits
+	(void)&threadExit;
+
+	std::lock_guard<std::mutex> guard(poolLock);
+	cache.registered = true;
+	cache.prev = 0;
+	cache.next = threads;
+	if( threads )
+		threads->prev = &cache;
+	threads = &cache;
+}
+
+SPoolThreadExit::~SPoolThreadExit()
+{
+	SPoolThreadCache &cache = threadCache;
+	if( !cache.registered || cache.exited )
+		return;
+
+	std::lock_guard<std::mutex> guard(poolLock);
+	for( asUINT n = 0; n < NUM_CLASSES; n++ )
+	{
+		while( cache.freeList[n] )
+		{
+			SPoolBlock *block = cache.freeList[n];
+			cache.freeList[n] = block->next;
+			PushShared(block, n);
+		}
+		cache.count[n] = 0;
+	}
+
+	exitedStats.allocations      += cache.allocations.load(std::memory_order_relaxed);
+	exitedStats.frees            += cache.frees.load(std::memory_order_relaxed);
+	exitedStats.largeAllocations += cache.largeAllocations.load(std::memory_order_relaxed);
+	exitedStats.cacheMisses      += cache.cacheMisses.load(std::memory_order_relaxed);
+	exitedStats.bytesInUse       += cache.bytesInUse.load(std::memory_order_relaxed);
+
+	if( cache.prev )
+		cache.prev->next = cache.next;
+	else
+		threads = cache.next;
+	if( cache.next )
+		cache.next->prev = cache.prev;
+
+	// Later allocations on this thread, e.g. from the destructors of other
+	// thread local objects, go directly to the shared free lists
+	cache.exited = true;
+}
+
+void *ScriptPoolAlloc(size_t size)
+{
+	SPoolThreadCache &cache = threadCache;
+	if( !cache.registered )
+		RegisterThread(cache);
+
+	asUINT sizeClass = GetSizeClass(size);
+	if( sizeClass == LARGE_CLASS )
+	{
+		SPoolHeader *header = reinterpret_cast<SPoolHeader*>(asAllocMem(sizeof(SPoolHeader) + size));
+		if( header == 0 )
+			return 0;
+		header->sizeClass = LARGE_CLASS;
+		header->size = sizeof(SPoolHeader) + size;
+
+		if( cache.exited )
+		{
+			std::lock_guard<std::mutex> guard(poolLock);
+			exitedStats.allocations++;
+			exitedStats.largeAllocations++;
+			exitedStats.bytesInUse += header->size;
+		}
+		else
+		{
+			AddCount(cache.allocations, 1);
+			AddCount(cache.largeAllocations, 1);
+			AddCount(cache.bytesInUse, header->size);
+		}
+		return header + 1;
+	}
+
+	SPoolBlock *block;
+	if( cache.exited )
+	{
+		std::lock_guard<std::mutex> guard(poolLock);
+		block = PopShared(sizeClass);
+		if( block == 0 )
+			return 0;
+		exitedStats.allocations++;
+		exitedStats.bytesInUse += classSizes[sizeClass];
+	}
+	else
+	{
+		if( cache.freeList[sizeClass] == 0 )
+		{
+			// Take a batch of blocks from the shared list
+			std::lock_guard<std::mutex> guard(poolLock);
+			for( asUINT n = 0; n < REFILL_COUNT; n++ )
+			{
+				SPoolBlock *shared = PopShared(sizeClass);
+				if( shared == 0 )
+					break;
+				shared->next = cache.freeList[sizeClass];
+				cache.freeList[sizeClass] = shared;
+				cache.count[sizeClass]++;
+			}
+			if( cache.freeList[sizeClass] == 0 )
+				return 0;
+			AddCount(cache.cacheMisses, 1);
+		}
+
+		block = cache.freeList[sizeClass];
+		cache.freeList[sizeClass] = block->next;
+		cache.count[sizeClass]--;
+
+		AddCount(cache.allocations, 1);
+		AddCount(cache.bytesInUse, classSizes[sizeClass]);
+	}
+
+	SPoolHeader *header = reinterpret_cast<SPoolHeader*>(block);
+	header->sizeClass = sizeClass;
+	return header + 1;
+}
+
+void ScriptPoolFree(void *ptr)
+{
+	if( ptr == 0 )
+		return;
+
+	SPoolThreadCache &cache = threadCache;
+	if( !cache.registered )
+		RegisterThread(cache);
+
+	SPoolHeader *header = reinterpret_cast<SPoolHeader*>(ptr) - 1;
+	asUINT sizeClass = header->sizeClass;
+	asQWORD size = sizeClass == LARGE_CLASS ? header->size : classSizes[sizeClass];
+	assert( sizeClass == LARGE_CLASS || sizeClass < NUM_CLASSES );
+
+	if( cache.exited )
+	{
+		std::lock_guard<std::mutex> guard(poolLock);
+		exitedStats.frees++;
+		exitedStats.bytesInUse -= size;
+		if( sizeClass != LARGE_CLASS )
+		{
+			PushShared(reinterpret_cast<SPoolBlock*>(header), sizeClass);
+			return;
+		}
+	}
+	else
+	{
+		AddCount(cache.frees, 1);
+		AddCount(cache.bytesInUse, asQWORD(0) - size);
+	}
+
+	if( sizeClass == LARGE_CLASS )
+	{
+		asFreeMem(header);
+		return;
+	}
+
+	SPoolBlock *block = reinterpret_cast<SPoolBlock*>(header);
+	block->next = cache.freeList[sizeClass];
+	cache.freeList[sizeClass] = block;
+
+	if( ++cache.count[sizeClass] > MAX_CACHED )
+	{
+		std::lock_guard<std::mutex> guard(poolLock);
+		while( cache.count[sizeClass] > MAX_CACHED / 2 )
+		{
+			block = cache.freeList[sizeClass];
+			cache.freeList[sizeClass] = block->next;
+			cache.count[sizeClass]--;
+			PushShared(block, sizeClass);
+		}
+	}
+}
+
+void GetScriptPoolStats(SScriptPoolStats &stats)
+{
+	std::lock_guard<std::mutex> guard(poolLock);
+	stats = exitedStats;
+	for( SPoolThreadCache *cache = threads; cache; cache = cache->next )
+	{
+		stats.allocations      += cache->allocations.load(std::memory_order_relaxed);
+		stats.frees            += cache->frees.load(std::memory_order_relaxed);
+		stats.largeAllocations += cache->largeAllocations.load(std::memory_order_relaxed);
+		stats.cacheMisses      += cache->cacheMisses.load(std::memory_order_relaxed);
+		stats.bytesInUse       += cache->bytesInUse.load(std::memory_order_relaxed);
+	}
+}
+
+void ScriptPoolRelease()
+{
+	std::lock_guard<std::mutex> guard(poolLock);
+
+	// The blocks cached by the threads are in the chunks that are freed
+	for( SPoolThreadCache *cache = threads; cache; cache = cache->next )
+	{
+		memset(cache->freeList, 0, sizeof(cache->freeList));
+		memset(cache->count, 0, sizeof(cache->count));
+	}
+	memset(sharedFreeList, 0, sizeof(sharedFreeList));
+
+	while( chunks )
+	{
+		SPoolBlock *chunk = chunks;
+		chunks = chunk->next;
+		asFreeMem(chunk);
+	}
+	exitedStats.bytesReserved = 0;
+}
+
+END_AS_NAMESPACE
@@ -0,0 +1,76 @@
+#ifndef SCRIPTPOOL_H
+#define SCRIPTPOOL_H
+
+// A pooled allocator for the container add-ons. Allocations are rounded up
+// to a size class and served from free lists, each thread keeping a cache
+// of free blocks so the common case doesn't need any locking. Larger
+// allocations are passed on to asAllocMem.
+//
+// The blocks of the size classes are carved from chunks that are allocated
+// with asAllocMem and kept until ScriptPoolRelease is called.
+
+#ifndef ANGELSCRIPT_H
+// Avoid having to inform include path if header is already include before
+#include <angelscript.h>
+#endif
+
+#include <stddef.h> // size_t
+#include <new>      // std::bad_alloc
+
+// The array, grid and dictionary use the pool by default. Define this
+// as 0 to have them use asAllocMem and asFreeMem directly.
+#ifndef AS_USE_SCRIPTPOOL
+#define AS_USE_SCRIPTPOOL 1
+#endif
+
+BEGIN_AS_NAMESPACE
+
+// The counters are summed over all threads. As the threads update their
+// own counters without locking, the sum can lag slightly behind
+struct SScriptPoolStats
+{
+	asQWORD allocations;      // Calls to ScriptPoolAlloc
+	asQWORD frees;            // Calls to ScriptPoolFree
+	asQWORD largeAllocations; // Allocations too large for the size classes
+	asQWORD cacheMisses;      // Allocations that had to refill the thread's cache
+	asQWORD bytesInUse;       // Size of the live allocations, rounded up to their size class
+	asQWORD bytesReserved;    // Size of the chunks allocated for the size classes
+};
+
+// Same signatures as asALLOCFUNC_t and asFREEFUNC_t, so they can be given to
+// CScriptArray::SetMemoryFunctions and CScriptGrid::SetMemoryFunctions
+void *ScriptPoolAlloc(size_t size);
+void  ScriptPoolFree(void *ptr);
+
+void  GetScriptPoolStats(SScriptPoolStats &stats);
+
+// Frees the chunks. All the memory from the pool must have been freed, and
+// no thread may use the pool at the same time
+void  ScriptPoolRelease();
+
+// STL allocator using the pool, e.g. for the map of the dictionary
+template<class T>
+class CScriptPoolAllocator
+{
+public:
+	typedef T value_type;
+
+	CScriptPoolAllocator() {}
+	template<class U> CScriptPoolAllocator(const CScriptPoolAllocator<U> &) {}
+
+	T *allocate(size_t n)
+	{
+		void *p = ScriptPoolAlloc(n * sizeof(T));
+		if( p == 0 )
+			throw std::bad_alloc();
+		return static_cast<T*>(p);
+	}
+	void deallocate(T *p, size_t) { ScriptPoolFree(p); }
+
+	template<class U> bool operator==(const CScriptPoolAllocator<U> &) const { return true; }
+	template<class U> bool operator!=(const CScriptPoolAllocator<U> &) const { return false; }
+};
+
+END_AS_NAMESPACE
+
+#endif
@@ -0,0 +1,206 @@
+#include "IncludeHandler.h"
+#include "AngelScript/scriptstdstring/scriptstdstring.h"
+#include "AngelScript/scriptfile/scriptfile.h"
+#include "AngelScript/scriptfile/scriptfilesystem.h"
+#include "AngelScript/scriptarray/scriptarray.h"
+#include "stingray/asif_dynamic_config.h"
+
+#include <sys/stat.h>
+#include <Windows.h>
+
+using namespace AngelScript;
+
+bool ReadFileContent(const std::string& file, std::string& content) {
+	FILE* f = fopen(file.c_str(), "rb");
+	if (!f) {
+		return false;
+	}
+	fseek(f, 0, SEEK_END);
+	long len = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	content.resize(len > 0 ? len : 0);
+	size_t c = len > 0 ? fread(&content[0], len, 1, f) : 1;
+	fclose(f);
+	return c == 1;
+}
+
+bool GetModifiedTime(const std::string& file, time_t& modified) {
+	struct stat st;
+	if (stat(file.c_str(), &st) != 0) {
+		return false;
+	}
+	modified = st.st_mtime;
+	return true;
+}
+
+#ifdef _WIN32
+static const long long STAMP_TICKS_PER_SECOND = 10000000;
+
+bool GetFileStamp(const std::string& file, FileStamp& stamp) {
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	if (!GetFileAttributesExA(file.c_str(), GetFileExInfoStandard, &data)) {
+		return false;
+	}
+	stamp.modified = ((long long)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+	stamp.size = ((long long)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+	return true;
+}
+
+static long long GetStampNow() {
+	FILETIME now;
+	GetSystemTimeAsFileTime(&now);
+	return ((long long)now.dwHighDateTime << 32) | now.dwLowDateTime;
+}
+#else
+static const long long STAMP_TICKS_PER_SECOND = 1000000000;
+
+bool GetFileStamp(const std::string& file, FileStamp& stamp) {
+	struct stat st;
+	if (stat(file.c_str(), &st) != 0) {
+		return false;
+	}
+	stamp.modified = (long long)st.st_mtim.tv_sec * STAMP_TICKS_PER_SECOND + st.st_mtim.tv_nsec;
+	stamp.size = st.st_size;
+	return true;
+}
+
+static long long GetStampNow() {
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	return (long long)now.tv_sec * STAMP_TICKS_PER_SECOND + now.tv_nsec;
+}
+#endif
+
+//A file written this close to being cached may be written again without changing its stamp
+static const long long STAMP_UNSAFE_WINDOW = 2 * STAMP_TICKS_PER_SECOND;
+
+FILE* g_LogStream = stdout;
+
+static void print(std::string str) {
+	fprintf(g_LogStream, "%s\n", str.c_str());
+}
+
+static void IncludeMessageCallback(const AngelScript::asSMessageInfo* msg, void* param) {
+	fprintf(g_LogStream, "%s\n", msg->message);
+}
+
+static std::string GetEnvVariable(std::string s) {
+	char buffer[256];
+	GetEnvironmentVariableA(s.c_str(), buffer, 256);
+	return std::string(buffer);
+}
+
+void SetupIncludeHandler(const std::string& file, IncludeHandler& ih) {
+	ih.engine = asCreateScriptEngine();
+	AngelScript::RegisterStdString(ih.engine);
+	AngelScript::RegisterScriptArray(ih.engine, true);
+	AngelScript::RegisterScriptFile(ih.engine);
+	AngelScript::RegisterScriptFileSystem(ih.engine);
+	ih.engine->RegisterGlobalFunction("void print(string s)", asFUNCTION(print), asCALL_CDECL);
+	ih.engine->RegisterGlobalFunction("string GetEnvVar(string s)", asFUNCTION(GetEnvVariable), asCALL_CDECL);
+	stingray::asif_dynamic_config::register_interface(ih.engine);
+
+	CScriptBuilder builder;
+	int r = 0;
+	r = ih.engine->SetMessageCallback(asFUNCTION(IncludeMessageCallback), 0, asCALL_CDECL);
+	r = builder.StartNewModule(ih.engine, file.c_str());
+	r = builder.AddSectionFromFile(file.c_str());
+	builder.BuildModule();
+	ih.script = builder.GetModule();
+	AngelScript::asIScriptFunction* func = ih.script->GetFunctionByDecl("string IncludeFile(string includeFile, string fromFile)");
+	if (!func) {
+		fprintf(g_LogStream, "Include handler has to define a function with declaration \"string IncludeFile(string includeFile, string fromFile)\"");
+	}
+	ih.func = func;
+	ih.ctx = ih.engine->CreateContext();
+	//run initialize
+	AngelScript::asIScriptFunction* initFunc =  ih.script->GetFunctionByDecl("bool InitializeIncluder()");
+	ih.ctx->Prepare(initFunc);
+	if (ih.ctx->Execute() == AngelScript::asEXECUTION_FINISHED) {
+
+	}
+}
+
+void ForgetInclude(IncludeHandler& ih, const std::string& sectionName) {
+	for (auto it = ih.cache.begin(); it != ih.cache.end();) {
+		if (it->second.sectionName == sectionName) {
+			it = ih.cache.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void ReleaseIncludeHandler(IncludeHandler& ih) {
+	if (ih.ctx) {
+		ih.ctx->Release();
+	}
+	if (ih.engine) {
+		ih.engine->ShutDownAndRelease();
+	}
+	ih = IncludeHandler();
+}
+
+static int AddCachedInclude(CachedInclude& entry, CScriptBuilder* builder) {
+	int r = builder->AddSectionFromMemory(entry.sectionName.c_str(), entry.content.c_str(), (unsigned int)entry.content.size());
+	return r < 0 ? -1 : 0;
+}
+
+int CustomInclude(const char* include, const char* from, CScriptBuilder* builder, void* userParam) {
+	IncludeHandler* includer = (IncludeHandler*)userParam;
+	auto key = std::make_pair(std::string(include), std::string(from));
+	auto cached = includer->cache.find(key);
+	if (cached != includer->cache.end()) {
+		CachedInclude& entry = cached->second;
+		FileStamp stamp;
+		if (GetFileStamp(entry.path, stamp)) {
+			if (stamp == entry.stamp && entry.cachedAt - entry.stamp.modified >= STAMP_UNSAFE_WINDOW) {
+				return AddCachedInclude(entry, builder);
+			}
+			long long now = GetStampNow();
+			std::string content;
+			if (ReadFileContent(entry.path, content)) {
+				AngelScript::asQWORD hash = CScriptBuilder::HashSection(content.c_str(), content.size());
+				if (hash != entry.hash) {
+					entry.content.swap(content);
+					entry.hash = hash;
+				}
+				entry.stamp = stamp;
+				entry.cachedAt = now;
+				return AddCachedInclude(entry, builder);
+			}
+		}
+		//the file is gone, let the resolver have another go at it
+		includer->cache.erase(cached);
+	}
+
+	includer->ctx->Prepare(includer->func);
+	std::string includeFile(include);
+	std::string fromFile(from);
+	includer->ctx->SetArgObject(0, &includeFile);
+	includer->ctx->SetArgObject(1, &fromFile);
+	int rCode = includer->ctx->Execute();
+	if (rCode == AngelScript::asEXECUTION_FINISHED) {
+
+	} else if (rCode == AngelScript::asEXECUTION_EXCEPTION) {
+		//printf exception
+		includer->resolveFailed = true;
+		return -1;
+	}
+	std::string* resolvedFile = (std::string*)includer->ctx->GetAddressOfReturnValue();
+	if (*resolvedFile == "error") {
+		includer->resolveFailed = true;
+		return -1;
+	}
+	CachedInclude entry;
+	entry.path = *resolvedFile;
+	//taken before the read, so a write during the read makes the entry look recent rather than old
+	entry.cachedAt = GetStampNow();
+	if (!GetFileStamp(entry.path, entry.stamp) || !ReadFileContent(entry.path, entry.content)) {
+		//let the builder report the missing file
+		return builder->AddSectionFromFile(entry.path.c_str()) < 0 ? -1 : 0;
+	}
+	entry.sectionName = CScriptBuilder::GetSectionNameForFile(entry.path.c_str());
+	entry.hash = CScriptBuilder::HashSection(entry.content.c_str(), entry.content.size());
+	return AddCachedInclude(includer->cache[key] = entry, builder);
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <angelscript.h>
+#include "AngelScript/scriptbuilder/scriptbuilder.h"
+#include <stdio.h>
+#include <time.h>
+#include <map>
+#include <string>
+
+bool ReadFileContent(const std::string& file, std::string& content);
+bool GetModifiedTime(const std::string& file, time_t& modified);
+
+//Size and last write time of a file, the time in the file system's resolution (100ns on Windows, ns elsewhere)
+struct FileStamp {
+	long long modified = 0;
+	long long size = -1;
+	bool operator==(const FileStamp& o) const { return modified == o.modified && size == o.size; }
+};
+bool GetFileStamp(const std::string& file, FileStamp& stamp);
+
+//A resolved #include. As long as the resolved file keeps its stamp neither the scripted resolver
+//nor the disk read has to run again. Files written shortly before they were cached are read again anyway,
+//as a second write can keep the stamp on file systems with a coarse time resolution.
+struct CachedInclude {
+	std::string path;
+	std::string sectionName;
+	std::string content;
+	FileStamp stamp;
+	long long cachedAt = 0; //same clock as stamp.modified
+	AngelScript::asQWORD hash;
+};
+
+/*
+Resolves #include directives through a script defining "string IncludeFile(string includeFile, string fromFile)",
+shared by Ash.exe and the extension's addon.
+*/
+struct IncludeHandler {
+	AngelScript::asIScriptEngine* engine = nullptr;
+	AngelScript::asIScriptContext* ctx = nullptr;
+	AngelScript::asIScriptModule* script = nullptr;
+	AngelScript::asIScriptFunction* func = nullptr;
+	//keyed by (include, from), lives as long as the handler so it is shared between builds in server mode
+	std::map<std::pair<std::string, std::string>, CachedInclude> cache;
+	//set when the include script failed to resolve an include during the current build
+	bool resolveFailed = false;
+};
+
+//Where the include script's print and compile errors go. In server mode stdout is reserved for responses
+extern FILE* g_LogStream;
+
+void SetupIncludeHandler(const std::string& file, IncludeHandler& ih);
+void ReleaseIncludeHandler(IncludeHandler& ih);
+//Drops the cached includes of a section, e.g. when its content turned out to be out of date
+void ForgetInclude(IncludeHandler& ih, const std::string& sectionName);
+//Include callback for CScriptBuilder, userParam is the IncludeHandler
+int CustomInclude(const char* include, const char* from, AngelScript::CScriptBuilder* builder, void* userParam);
@@ -1,13 +1,11 @@
 
 #include <angelscript.h>
 #include <AngelScriptExporter.h>
+#include <SymbolIndex.h>
+#include <BytecodeReport.h>
 #include "AngelScript/scriptbuilder/scriptbuilder.h"
-#include "scriptstdstring.h"
-#include "scriptfile.h"
-#include "scriptfilesystem.h"
-#include "scriptarray.h"
+#include "IncludeHandler.h"
 
-#include "stingray/asif_dynamic_config.h"
 
 #include <rapidjson/document.h>
 #include <rapidjson/filewritestream.h>
@@ -16,10 +14,16 @@
 #include <rapidjson/writer.h>
 #include <rapidjson/stringbuffer.h> 
 
+#include <atomic>
 #include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
 #include <string>
+#include <thread>
 #include <vector>
 #include <assert.h>
+#include <stdlib.h>
 #include <Windows.h>
 
 using namespace AngelScript;
@@ -27,7 +31,12 @@ using namespace AngelScript;
 enum OPERATION {
 	REFLECT_MODULE = 0x1,
 	COMPILE_FILE = 0x2,
-	PRINT_HELP = 0x4
+	PRINT_HELP = 0x4,
+	SERVER_MODE = 0x8,
+	EXPORT_BINARY_INTERFACE = 0x10,
+	BATCH_COMPILE = 0x20,
+	EXPORT_SYMBOL_INDEX = 0x40,
+	EXPORT_BYTECODE_REPORT = 0x80
 };
 
 struct AppArguments {
@@ -37,6 +46,14 @@ struct AppArguments {
 	std::vector<std::string> defines; //TODO
 	std::string includeHandler;
 	std::string output; //output path of the module reflection
+	std::string binaryInterfaceOutput; //output path of the binary interface image
+	std::string symbolIndexOutput; //output path of the symbol index
+	std::string bytecodeReportOutput; //output path of the bytecode report
+	std::string debugDumps; //AS_DEBUG directory of an engine debug build, merged into the bytecode report
+	std::string batch; //manifest or directory of entry points
+	uint32_t threads = 0; //worker threads for batch compiles, 0 = hardware concurrency
+	uint32_t maxErrors = 0; //stop reporting errors after this many, 0 = no limit
+	bool shardReflection = false; //write the module reflection as an index and one file per section
 	uint32_t operation = PRINT_HELP;
 };
 
@@ -67,6 +84,58 @@ std::string ParseArgs(int argc, char** argv, AppArguments& args) {
 			i++;
 			args.defines.push_back(argv[i]);
 		}
+		if (strcmp(argv[i], "-b") == 0) {
+			args.operation |= EXPORT_BINARY_INTERFACE;
+			i++;
+			args.binaryInterfaceOutput = argv[i];
+		}
+		if (strcmp(argv[i], "-x") == 0) {
+			args.operation |= EXPORT_SYMBOL_INDEX;
+			i++;
+			args.symbolIndexOutput = argv[i];
+		}
+		if (strcmp(argv[i], "--bytecode") == 0) {
+			args.operation |= EXPORT_BYTECODE_REPORT;
+			i++;
+			args.bytecodeReportOutput = argv[i];
+		}
+		if (strcmp(argv[i], "--dumps") == 0) {
+			i++;
+			args.debugDumps = argv[i];
+		}
+		if (strcmp(argv[i], "--server") == 0) {
+			args.operation |= SERVER_MODE;
+		}
+		if (strcmp(argv[i], "--batch") == 0) {
+			args.operation |= BATCH_COMPILE;
+			i++;
+			args.batch = argv[i];
+		}
+		if (strcmp(argv[i], "-e") == 0) {
+			i++;
+			args.maxErrors = atoi(argv[i]);
+		}
+		if (strcmp(argv[i], "--shard") == 0) {
+			args.shardReflection = true;
+		}
+		if (strcmp(argv[i], "-j") == 0) {
+			i++;
+			args.threads = atoi(argv[i]);
+		}
+	}
+	if (args.operation & SERVER_MODE) {
+		//source files are given per request in server mode
+		return "";
+	}
+	if (args.operation & BATCH_COMPILE) {
+		return args.batch.empty() ? "Missing batch manifest" : "";
+	}
+	if (args.operation & EXPORT_BYTECODE_REPORT && args.sourceFile.empty()) {
+		//without a source file the report only contains what the dumps have
+		return args.debugDumps.empty() ? "Missing source file or AS_DEBUG dumps" : "";
+	}
+	if (args.operation & (EXPORT_BINARY_INTERFACE | EXPORT_SYMBOL_INDEX) && !(args.operation & (REFLECT_MODULE | COMPILE_FILE))) {
+		return args.interfaceFile.empty() ? "Missing interface file" : "";
 	}
 	if (args.operation & (REFLECT_MODULE | COMPILE_FILE) && args.sourceFile.empty()) {
 		return "Missing source file";
@@ -82,8 +151,136 @@ struct Message {
 	std::string message;
 };
 
-std::vector<Message> g_Messages;
+/*
+Writes the diagnostics json straight to stdout while the engine reports messages, instead of collecting
+everything in a Document first. Errors are written as soon as they are reported, warnings and infos are few
+and are kept until the error array has been closed, so the output has the same layout as before:
+	{ "Errors": [ ... ], "Warnings": [ ... ], "Infos": [ ... ] }
+With maxErrors set, errors past the limit are dropped and "Truncated" is added. exitOnLimit closes the object
+and exits as soon as the limit is hit, only use it when the object holds nothing but the diagnostics.
+*/
+class DiagnosticsWriter {
+public:
+	DiagnosticsWriter(uint32_t maxErrors = 0, bool exitOnLimit = false, bool keepMessages = false) :
+		stream(stdout, buffer, sizeof(buffer)), writer(stream), maxErrors(maxErrors), errorCount(0),
+		exitOnLimit(exitOnLimit), keepMessages(keepMessages), truncated(false) {}
+
+	rapidjson::Writer<rapidjson::FileWriteStream>& Json() {
+		return writer;
+	}
+
+	void BeginMessages() {
+		writer.Key("Errors");
+		writer.StartArray();
+	}
+
+	void Add(const Message& m) {
+		if (m.type != asEMsgType::asMSGTYPE_ERROR) {
+			deferred.push_back(m);
+			if (keepMessages) {
+				kept.push_back(m);
+			}
+			return;
+		}
+		if (maxErrors && errorCount >= maxErrors) {
+			truncated = true;
+			return;
+		}
+		WriteMessage(m);
+		if (keepMessages) {
+			kept.push_back(m);
+		}
+		if (++errorCount == 1) {
+			//get the first error out right away
+			Flush();
+		}
+		if (exitOnLimit && errorCount == maxErrors) {
+			truncated = true;
+			EndMessages();
+			writer.EndObject();
+			Flush();
+			std::quick_exit(0);
+		}
+	}
+
+	void EndMessages() {
+		writer.EndArray();
+		writer.Key("Warnings");
+		writer.StartArray();
+		for (auto& m : deferred) {
+			if (m.type == asEMsgType::asMSGTYPE_WARNING) {
+				WriteMessage(m);
+			}
+		}
+		writer.EndArray();
+		writer.Key("Infos");
+		writer.StartArray();
+		for (auto& m : deferred) {
+			if (m.type == asEMsgType::asMSGTYPE_INFORMATION) {
+				WriteMessage(m);
+			}
+		}
+		writer.EndArray();
+		if (truncated) {
+			writer.Key("Truncated");
+			writer.Bool(true);
+		}
+	}
+
+	void NewLine() {
+		stream.Put('\n');
+	}
+
+	void Flush() {
+		stream.Flush();
+		fflush(stdout);
+	}
+
+	//Messages that made it into the output, only recorded with keepMessages
+	const std::vector<Message>& GetMessages() const {
+		return kept;
+	}
+
+	//Errors were dropped because of maxErrors
+	bool IsTruncated() const {
+		return truncated;
+	}
+
+	//For messages replayed from a build that was truncated
+	void SetTruncated() {
+		truncated = true;
+	}
+
+private:
+	void WriteMessage(const Message& m) {
+		writer.StartObject();
+		writer.Key("Line");
+		writer.Uint(m.line);
+		writer.Key("Column");
+		writer.Uint(m.column);
+		writer.Key("Message");
+		writer.String(m.message.c_str(), (rapidjson::SizeType)m.message.size());
+		writer.Key("Section");
+		writer.String(m.section.c_str(), (rapidjson::SizeType)m.section.size());
+		writer.EndObject();
+	}
+
+	char buffer[4096];
+	rapidjson::FileWriteStream stream;
+	rapidjson::Writer<rapidjson::FileWriteStream> writer;
+	std::vector<Message> deferred;
+	std::vector<Message> kept;
+	uint32_t maxErrors;
+	uint32_t errorCount;
+	bool exitOnLimit;
+	bool keepMessages;
+	bool truncated;
+};
+
+//The writer of the build currently running on the main thread
+DiagnosticsWriter* g_Diagnostics = nullptr;
 
+//param is the message list of the engine, engines without one report to g_Diagnostics
 void MessageCallback(const AngelScript::asSMessageInfo* msg, void* param) {
 	Message m;
 	m.line = msg->row;
@@ -91,118 +288,461 @@ void MessageCallback(const AngelScript::asSMessageInfo* msg, void* param) {
 	m.type = msg->type;
 	m.section = msg->section;
 	m.message = msg->message;
-	g_Messages.push_back(m);
+	if (param) {
+		((std::vector<Message>*)param)->push_back(m);
+	} else if (g_Diagnostics) {
+		g_Diagnostics->Add(m);
+	}
 }
 
-void FormatAndPrintMessages() {
-	using namespace rapidjson;
-
-	Document output;
-	output.SetObject();
-	Value errors = Value(kArrayType);
-	Value warnings = Value(kArrayType);
-	Value infos = Value(kArrayType);
-
-	for (auto& m : g_Messages) {
-		Value message = Value(kObjectType);
-		message.AddMember("Line", Value(m.line), output.GetAllocator());
-		message.AddMember("Column", Value(m.column), output.GetAllocator());
-		message.AddMember("Message", Value(m.message.c_str(), output.GetAllocator()), output.GetAllocator());
-		message.AddMember("Section", Value(m.section.c_str(), output.GetAllocator()), output.GetAllocator());
-		if (m.type == asEMsgType::asMSGTYPE_ERROR) {
-			errors.PushBack(message, output.GetAllocator());
-		} else if (m.type == asEMsgType::asMSGTYPE_WARNING) {
-			warnings.PushBack(message, output.GetAllocator());
-		} else if (m.type == asEMsgType::asMSGTYPE_INFORMATION) {
-			infos.PushBack(message, output.GetAllocator());
-		}
-	}
-	output.AddMember("Errors", errors, output.GetAllocator());
-	output.AddMember("Warnings", warnings, output.GetAllocator());
-	output.AddMember("Infos", infos, output.GetAllocator());
-
-	StringBuffer buffer;
-	Writer<StringBuffer> writer(buffer);
-	output.Accept(writer);
-
-	printf("%s", buffer.GetString());
+AngelScript::asIScriptEngine* CreateCompileEngine(const std::string& interfaceFile, std::vector<Message>* messages = nullptr) {
+	AngelScript::asIScriptEngine* engine = asCreateScriptEngine();
+	int r = 0;
+	r = engine->SetMessageCallback(asFUNCTION(MessageCallback), messages, asCALL_CDECL);
+	r = engine->SetEngineProperty(asEP_INIT_GLOBAL_VARS_AFTER_BUILD, false);
+	//load interface, the binary image is preferred and anything else is treated as json
+	if (!interfaceFile.empty() && AngelScriptExporter::ImportEngineFromBinary(interfaceFile.c_str(), engine) == AngelScriptExporter::BINARY_IMPORT_NOT_BINARY) {
+		AngelScriptExporter::ImportEngineFromJson(interfaceFile.c_str(), engine);
+	}
+	return engine;
 }
 
+int BuildScript(AngelScript::asIScriptEngine* engine, IncludeHandler* includer, const std::string& sourceFile, const std::vector<std::string>& defines, CScriptBuilder& builder) {
+	if (includer) {
+		includer->resolveFailed = false;
+		builder.SetIncludeCallback(CustomInclude, includer);
+	}
+	int r = builder.StartNewModule(engine, sourceFile.c_str());
+	for (auto& d : defines) {
+		builder.DefineWord(d.c_str());
+	}
+	r = builder.AddSectionFromFile(sourceFile.c_str());
+	//This will compile the file and "print" any errors into the message list
+	return builder.BuildModule();
+}
 
-struct IncludeHandler {
-	AngelScript::asIScriptEngine* engine;
-	AngelScript::asIScriptContext* ctx;
-	AngelScript::asIScriptModule* script;
-	AngelScript::asIScriptFunction* func;
+//Modules built in server mode, keyed by source file. A module is reused as long as the defines are the same
+//and none of the sections it was built from, including the ones pulled in by #include, changed on disk.
+struct CachedModule {
+	std::map<std::string, AngelScript::asQWORD> sectionHashes;
+	std::set<std::string> missingFiles; //files that failed to open, the module is stale once one of them exists
+	bool resolveFailed = false; //the include script couldn't resolve an include, there is no path to watch so it is always rebuilt
+	std::vector<std::string> defines;
+	std::vector<Message> messages;
+	bool truncated = false;
+	uint32_t maxErrors = 0;
+	int result = 0;
+	AngelScriptExporter::SymbolIndex symbols; //built on the first completion request for the module
+	bool symbolsBuilt = false;
 };
 
-void print(std::string str) {
-	printf("%s\n", str.c_str());
+std::map<std::string, CachedModule> g_ModuleCache;
+
+//A section whose content changed is dropped from the include cache of includer, so the rebuild reads it from disk
+bool IsModuleUpToDate(const CachedModule& cached, const std::vector<std::string>& defines, uint32_t maxErrors, IncludeHandler* includer) {
+	if (cached.defines != defines || cached.resolveFailed || cached.maxErrors != maxErrors) {
+		return false;
+	}
+	time_t modified;
+	for (auto& missing : cached.missingFiles) {
+		if (GetModifiedTime(missing, modified)) {
+			return false;
+		}
+	}
+	//every section is checked so all the changed ones are dropped from the include cache
+	bool upToDate = true;
+	std::string content;
+	for (auto& section : cached.sectionHashes) {
+		if (!ReadFileContent(section.first, content)) {
+			return false;
+		}
+		if (CScriptBuilder::HashSection(content.c_str(), content.size()) != section.second) {
+			if (!includer) {
+				return false;
+			}
+			ForgetInclude(*includer, section.first);
+			upToDate = false;
+		}
+	}
+	return upToDate;
 }
 
-void IncludeMessageCallback(const AngelScript::asSMessageInfo* msg, void* param) {
-	printf("%s\n", msg->message);
+/*
+Server mode keeps the engine with the imported interface and the include handler alive between requests.
+Requests are read from stdin as one JSON object per line:
+	{ "Id": 1, "Command": "Compile", "Source": "main.as", "Defines": [ "EDITOR" ] }
+	{ "Id": 2, "Command": "Reflect", "Source": "main.as", "Output": "cache/main.json", "Sharded": true }
+	{ "Id": 3, "Command": "Complete", "Prefix": "Get", "Namespace": "", "Kinds": [ "Function" ], "Source": "main.as", "Max": 50 }
+	{ "Command": "Shutdown" }
+Complete looks the prefix up in the symbol index of the interface and, with "Source", of that module if it is built.
+An optional "Interface" member reloads the engine interface if it differs from the current one.
+Modules are only rebuilt when one of their sections changed, "Force": true always rebuilds.
+Every request is answered with a single line on stdout containing the diagnostics of that request.
+*/
+int RunServer(AppArguments& args) {
+	using namespace rapidjson;
+	g_LogStream = stderr;
+
+	std::string interfaceFile = args.interfaceFile;
+	AngelScript::asIScriptEngine* engine = CreateCompileEngine(interfaceFile);
+	IncludeHandler includer;
+	IncludeHandler* includerPtr = nullptr;
+	if (!args.includeHandler.empty()) {
+		SetupIncludeHandler(args.includeHandler, includer);
+		includerPtr = &includer;
+	}
+	AngelScriptExporter::SymbolIndex engineSymbols;
+	bool engineSymbolsBuilt = false;
+
+	std::string line;
+	while (std::getline(std::cin, line)) {
+		if (line.empty() || line == "\r") {
+			continue;
+		}
+		Document request;
+		request.Parse(line.c_str());
+		bool valid = !request.HasParseError() && request.IsObject() && request.HasMember("Command") && request["Command"].IsString();
+		std::string command = valid ? request["Command"].GetString() : "";
+		if (command == "Shutdown") {
+			break;
+		}
+
+		uint32_t maxErrors = args.maxErrors;
+		if (valid && request.HasMember("MaxErrors") && request["MaxErrors"].IsUint()) {
+			maxErrors = request["MaxErrors"].GetUint();
+		}
+		DiagnosticsWriter diagnostics(maxErrors, false, true);
+		auto& response = diagnostics.Json();
+		response.StartObject();
+
+		if (!valid) {
+			response.Key("Error");
+			response.String("Invalid request");
+		} else {
+			if (request.HasMember("Id")) {
+				response.Key("Id");
+				request["Id"].Accept(response);
+			}
+			if (request.HasMember("Interface") && request["Interface"].IsString() && interfaceFile != request["Interface"].GetString()) {
+				interfaceFile = request["Interface"].GetString();
+				g_ModuleCache.clear();
+				engineSymbols.Clear();
+				engineSymbolsBuilt = false;
+				engine->ShutDownAndRelease();
+				engine = CreateCompileEngine(interfaceFile);
+			}
+
+			std::string sourceFile = request.HasMember("Source") && request["Source"].IsString() ? request["Source"].GetString() : "";
+			if ((command == "Compile" || command == "Reflect") && !sourceFile.empty()) {
+				std::vector<std::string> defines = args.defines;
+				if (request.HasMember("Defines") && request["Defines"].IsArray()) {
+					for (auto& d : request["Defines"].GetArray()) {
+						if (d.IsString()) {
+							defines.push_back(d.GetString());
+						}
+					}
+				}
+				bool force = request.HasMember("Force") && request["Force"].IsBool() && request["Force"].GetBool();
+				auto cached = g_ModuleCache.find(sourceFile);
+				asIScriptModule* module = nullptr;
+				int r = 0;
+				bool fromCache = false;
+				if (!force && cached != g_ModuleCache.end() && IsModuleUpToDate(cached->second, defines, maxErrors, includerPtr)) {
+					module = engine->GetModule(sourceFile.c_str(), asGM_ONLY_IF_EXISTS);
+					fromCache = module != nullptr;
+				}
+				diagnostics.BeginMessages();
+				if (fromCache) {
+					for (auto& m : cached->second.messages) {
+						diagnostics.Add(m);
+					}
+					if (cached->second.truncated) {
+						diagnostics.SetTruncated();
+					}
+					r = cached->second.result;
+				} else {
+					CScriptBuilder builder;
+					g_Diagnostics = &diagnostics;
+					r = BuildScript(engine, includerPtr, sourceFile, defines, builder);
+					g_Diagnostics = nullptr;
+					module = builder.GetModule();
+					CachedModule& entry = g_ModuleCache[sourceFile];
+					entry.sectionHashes = builder.GetSectionHashes();
+					entry.missingFiles = builder.GetMissingFiles();
+					entry.resolveFailed = includerPtr && includerPtr->resolveFailed;
+					entry.defines = defines;
+					entry.messages = diagnostics.GetMessages();
+					entry.truncated = diagnostics.IsTruncated();
+					entry.maxErrors = maxErrors;
+					entry.result = r;
+					entry.symbols.Clear();
+					entry.symbolsBuilt = false;
+				}
+				diagnostics.EndMessages();
+				bool reflected = false;
+				if (r >= 0 && command == "Reflect" && request.HasMember("Output") && request["Output"].IsString()) {
+					if (request.HasMember("Sharded") && request["Sharded"].IsBool() && request["Sharded"].GetBool()) {
+						AngelScriptExporter::ExportModuleAsShards(request["Output"].GetString(), module, engine);
+					} else {
+						AngelScriptExporter::ExportModuleAsJSON(request["Output"].GetString(), module, engine);
+					}
+					reflected = true;
+				}
+				response.Key("Success");
+				response.Bool(r >= 0);
+				response.Key("Cached");
+				response.Bool(fromCache);
+				if (command == "Reflect") {
+					response.Key("Reflected");
+					response.Bool(reflected);
+				}
+			} else if (command == "Complete") {
+				std::string prefix = request.HasMember("Prefix") && request["Prefix"].IsString() ? request["Prefix"].GetString() : "";
+				const char* nameSpace = request.HasMember("Namespace") && request["Namespace"].IsString() ? request["Namespace"].GetString() : nullptr;
+				uint32_t maxResults = request.HasMember("Max") && request["Max"].IsUint() ? request["Max"].GetUint() : 0;
+				uint32_t kinds = AngelScriptExporter::SYMBOL_ALL;
+				if (request.HasMember("Kinds") && request["Kinds"].IsArray()) {
+					kinds = 0;
+					for (auto& k : request["Kinds"].GetArray()) {
+						kinds |= k.IsString() ? AngelScriptExporter::GetSymbolKindByName(k.GetString()) : 0;
+					}
+				}
+				if (!engineSymbolsBuilt) {
+					engineSymbols.AddEngine(engine);
+					engineSymbolsBuilt = true;
+				}
+				std::vector<const AngelScriptExporter::Symbol*> results;
+				engineSymbols.Find(prefix.c_str(), results, kinds, nameSpace, maxResults);
+				auto cached = g_ModuleCache.find(sourceFile);
+				if (cached != g_ModuleCache.end() && cached->second.result >= 0 && (!maxResults || results.size() < maxResults)) {
+					if (!cached->second.symbolsBuilt) {
+						asIScriptModule* module = engine->GetModule(sourceFile.c_str(), asGM_ONLY_IF_EXISTS);
+						if (module) {
+							cached->second.symbols.AddModule(module);
+						}
+						cached->second.symbolsBuilt = true;
+					}
+					cached->second.symbols.Find(prefix.c_str(), results, kinds, nameSpace, maxResults ? maxResults - results.size() : 0);
+				}
+				response.Key("Symbols");
+				response.StartArray();
+				for (auto symbol : results) {
+					response.StartObject();
+					response.Key("Name");
+					response.String(symbol->name.c_str());
+					response.Key("Namespace");
+					response.String(symbol->nameSpace.c_str());
+					response.Key("Kind");
+					response.String(AngelScriptExporter::GetSymbolKindName(symbol->kind));
+					response.Key("Declaration");
+					response.String(symbol->declaration.c_str());
+					response.EndObject();
+				}
+				response.EndArray();
+			} else if (command == "Compile" || command == "Reflect") {
+				response.Key("Error");
+				response.String("Missing source file");
+			} else {
+				response.Key("Error");
+				response.String("Unknown command");
+			}
+		}
+
+		response.EndObject();
+		diagnostics.NewLine();
+		diagnostics.Flush();
+	}
+
+	if (includerPtr) {
+		ReleaseIncludeHandler(includer);
+	}
+	engine->ShutDownAndRelease();
+	return 0;
 }
 
-std::string GetEnvVariable(std::string s) {
-	char buffer[256];
-	GetEnvironmentVariableA(s.c_str(), buffer, 256);
-	return std::string(buffer);
+std::string GetDirectory(const std::string& file) {
+	size_t slash = file.find_last_of("/\\");
+	return slash == std::string::npos ? "" : file.substr(0, slash + 1);
 }
 
-void SetupIncludeHandler(std::string& file, IncludeHandler& ih) {
-	ih.engine = asCreateScriptEngine();
-	AngelScript::RegisterStdString(ih.engine);
-	AngelScript::RegisterScriptArray(ih.engine, true);
-	AngelScript::RegisterScriptFile(ih.engine);
-	AngelScript::RegisterScriptFileSystem(ih.engine);
-	ih.engine->RegisterGlobalFunction("void print(string s)", asFUNCTION(print), asCALL_CDECL);
-	ih.engine->RegisterGlobalFunction("string GetEnvVar(string s)", asFUNCTION(GetEnvVariable), asCALL_CDECL);
-	stingray::asif_dynamic_config::register_interface(ih.engine);
-
-	CScriptBuilder builder;
-	int r = 0;
-	r = ih.engine->SetMessageCallback(asFUNCTION(IncludeMessageCallback), 0, asCALL_CDECL);
-	r = builder.StartNewModule(ih.engine, file.c_str());
-	r = builder.AddSectionFromFile(file.c_str());
-	builder.BuildModule();
-	ih.script = builder.GetModule();
-	AngelScript::asIScriptFunction* func = ih.script->GetFunctionByDecl("string IncludeFile(string includeFile, string fromFile)");
-	if (!func) {
-		printf("Include handler has to define a function with declaration \"string IncludeFile(string includeFile, string fromFile)\"");
-	}
-	ih.func = func;
-	ih.ctx = ih.engine->CreateContext();
-	//run initialize
-	AngelScript::asIScriptFunction* initFunc =  ih.script->GetFunctionByDecl("bool InitializeIncluder()");
-	ih.ctx->Prepare(initFunc);
-	if (ih.ctx->Execute() == AngelScript::asEXECUTION_FINISHED) {
+//Entry points of a batch compile, either every .as file in a directory or the "Sources" of a json manifest.
+//Relative paths in a manifest are relative to the manifest.
+bool GetBatchSources(const std::string& batch, std::vector<std::string>& sources, std::vector<std::string>& defines) {
+	DWORD attributes = GetFileAttributesA(batch.c_str());
+	if (attributes == INVALID_FILE_ATTRIBUTES) {
+		return false;
+	}
+	if (attributes & FILE_ATTRIBUTE_DIRECTORY) {
+		std::string dir = batch;
+		if (dir.back() != '/' && dir.back() != '\\') {
+			dir += "/";
+		}
+		WIN32_FIND_DATAA data;
+		HANDLE find = FindFirstFileA((dir + "*.as").c_str(), &data);
+		if (find == INVALID_HANDLE_VALUE) {
+			return true;
+		}
+		do {
+			if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+				sources.push_back(dir + data.cFileName);
+			}
+		} while (FindNextFileA(find, &data));
+		FindClose(find);
+		return true;
+	}
 
+	std::string content;
+	if (!ReadFileContent(batch, content)) {
+		return false;
 	}
+	rapidjson::Document manifest;
+	manifest.Parse(content.c_str());
+	if (manifest.HasParseError() || !manifest.IsObject() || !manifest.HasMember("Sources") || !manifest["Sources"].IsArray()) {
+		return false;
+	}
+	std::string dir = GetDirectory(batch);
+	for (auto& source : manifest["Sources"].GetArray()) {
+		if (source.IsString()) {
+			std::string file = source.GetString();
+			bool absolute = file.find(':') != std::string::npos || (!file.empty() && (file[0] == '/' || file[0] == '\\'));
+			sources.push_back(absolute ? file : dir + file);
+		}
+	}
+	if (manifest.HasMember("Defines") && manifest["Defines"].IsArray()) {
+		for (auto& d : manifest["Defines"].GetArray()) {
+			if (d.IsString()) {
+				defines.push_back(d.GetString());
+			}
+		}
+	}
+	return true;
 }
 
-int CustomInclude(const char* include, const char* from, CScriptBuilder* builder, void* userParam) {
-	IncludeHandler* includer = (IncludeHandler*)userParam;
-	includer->ctx->Prepare(includer->func);
-	std::string includeFile(include);
-	std::string fromFile(from);
-	includer->ctx->SetArgObject(0, &includeFile);
-	includer->ctx->SetArgObject(1, &fromFile);
-	int rCode = includer->ctx->Execute();
-	if (rCode == AngelScript::asEXECUTION_FINISHED) {
-
-	} else if (rCode == AngelScript::asEXECUTION_EXCEPTION) {
-		//printf exception
-		return -1;
-	}
-	std::string* fileContent = (std::string*)includer->ctx->GetAddressOfReturnValue();
-	if (*fileContent != "error") {
-		builder->AddSectionFromFile(fileContent->c_str());
-	} else {
-		return -1;
+//Adds the per function dumps and stats.txt an AS_DEBUG build of the engine writes to dir
+bool AddDebugDumps(const std::string& debugDumps, AngelScriptExporter::BytecodeReport& report) {
+	std::string dir = debugDumps;
+	if (dir.back() != '/' && dir.back() != '\\') {
+		dir += "/";
 	}
-	
-	return 0;
+	WIN32_FIND_DATAA data;
+	HANDLE find = FindFirstFileA((dir + "*.txt").c_str(), &data);
+	if (find == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	do {
+		if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+			continue;
+		}
+		if (strcmp(data.cFileName, "stats.txt") == 0) {
+			report.AddStats((dir + data.cFileName).c_str());
+		} else if (strncmp(data.cFileName, "__", 2) == 0) {
+			report.AddDump((dir + data.cFileName).c_str());
+		}
+	} while (FindNextFileA(find, &data));
+	FindClose(find);
+	return true;
+}
+
+struct BatchResult {
+	std::string source;
+	int result = 0;
+	std::vector<Message> messages;
+};
+
+/*
+Compiles every entry point of a batch on a pool of worker threads.
+AngelScript engines can't build modules concurrently, so each worker has its own engine and include handler
+which it reuses for every module it picks up. The diagnostics of all modules are merged into one json object,
+messages from sections shared between modules are only reported once.
+*/
+int RunBatch(AppArguments& args) {
+	using namespace rapidjson;
+	g_LogStream = stderr;
+
+	std::vector<std::string> sources;
+	std::vector<std::string> defines = args.defines;
+	if (!GetBatchSources(args.batch, sources, defines)) {
+		printf("Invalid batch manifest\n");
+		return 1;
+	}
+
+	std::vector<BatchResult> results(sources.size());
+	std::atomic<size_t> next(0);
+	uint32_t threadCount = args.threads ? args.threads : std::thread::hardware_concurrency();
+	if (threadCount == 0) {
+		threadCount = 1;
+	}
+	if (threadCount > sources.size()) {
+		threadCount = (uint32_t)sources.size();
+	}
+
+	AngelScript::asPrepareMultithread();
+	auto worker = [&]() {
+		std::vector<Message> messages;
+		AngelScript::asIScriptEngine* engine = CreateCompileEngine(args.interfaceFile, &messages);
+		IncludeHandler includer;
+		IncludeHandler* includerPtr = nullptr;
+		if (!args.includeHandler.empty()) {
+			SetupIncludeHandler(args.includeHandler, includer);
+			includerPtr = &includer;
+		}
+		for (size_t i = next++; i < sources.size(); i = next++) {
+			messages.clear();
+			CScriptBuilder builder;
+			results[i].source = sources[i];
+			results[i].result = BuildScript(engine, includerPtr, sources[i], defines, builder);
+			results[i].messages.swap(messages);
+			if (builder.GetModule()) {
+				builder.GetModule()->Discard();
+			}
+		}
+		if (includerPtr) {
+			ReleaseIncludeHandler(includer);
+		}
+		engine->ShutDownAndRelease();
+		AngelScript::asThreadCleanup();
+	};
+	std::vector<std::thread> threads;
+	for (uint32_t t = 0; t < threadCount; ++t) {
+		threads.push_back(std::thread(worker));
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+
+	std::vector<Message> merged;
+	std::set<std::string> seen;
+	Document output;
+	Value modules = Value(kArrayType);
+	bool success = true;
+	for (auto& result : results) {
+		Value module = Value(kObjectType);
+		module.AddMember("Source", Value(result.source.c_str(), output.GetAllocator()), output.GetAllocator());
+		module.AddMember("Success", Value(result.result >= 0), output.GetAllocator());
+		modules.PushBack(module, output.GetAllocator());
+		success &= result.result >= 0;
+		for (auto& m : result.messages) {
+			std::string key = std::to_string(m.type) + ":" + m.section + ":" + std::to_string(m.line) + ":" + std::to_string(m.column) + ":" + m.message;
+			if (seen.insert(key).second) {
+				merged.push_back(m);
+			}
+		}
+	}
+	DiagnosticsWriter diagnostics(args.maxErrors);
+	auto& json = diagnostics.Json();
+	json.StartObject();
+	json.Key("Success");
+	json.Bool(success);
+	json.Key("Modules");
+	modules.Accept(json);
+	diagnostics.BeginMessages();
+	for (auto& m : merged) {
+		diagnostics.Add(m);
+	}
+	diagnostics.EndMessages();
+	json.EndObject();
+	diagnostics.Flush();
+	return success ? 0 : 1;
 }
 
 int main(int argc, char** argv) {
@@ -210,38 +750,84 @@ int main(int argc, char** argv) {
 
 	//while (!IsDebuggerPresent()){ Sleep(10); }
 	std::string error = ParseArgs(argc, argv, args);
+	if (error.empty() && args.operation & SERVER_MODE) {
+		return RunServer(args);
+	}
+	if (error.empty() && args.operation & BATCH_COMPILE) {
+		return RunBatch(args);
+	}
+	if (error.empty() && args.operation & EXPORT_BYTECODE_REPORT && args.sourceFile.empty()) {
+		AngelScriptExporter::BytecodeReport report;
+		if (!AddDebugDumps(args.debugDumps, report)) {
+			printf("No AS_DEBUG dumps in %s\n", args.debugDumps.c_str());
+		}
+		report.Write(args.bytecodeReportOutput.c_str());
+		return 0;
+	}
 	if (error.empty()) {
 		//Create Engine
-		AngelScript::asIScriptEngine* engine = asCreateScriptEngine();
-		int r = 0;
-		r = engine->SetMessageCallback(asFUNCTION(MessageCallback), 0, asCALL_CDECL);
-		r = engine->SetEngineProperty(asEP_INIT_GLOBAL_VARS_AFTER_BUILD, false);
-		//load interface
-		if (!args.interfaceFile.empty()) {
-			AngelScriptExporter::ImportEngineFromJson(args.interfaceFile.c_str(), engine);
-		}
-		
+		AngelScript::asIScriptEngine* engine = CreateCompileEngine(args.interfaceFile);
+		if (args.operation & EXPORT_BINARY_INTERFACE) {
+			AngelScriptExporter::ExportEngineAsBinary(args.binaryInterfaceOutput.c_str(), engine);
+		}
+		AngelScriptExporter::SymbolIndex symbols;
+		if (args.operation & EXPORT_SYMBOL_INDEX) {
+			symbols.AddEngine(engine);
+		}
+		if (args.operation & (EXPORT_BINARY_INTERFACE | EXPORT_SYMBOL_INDEX) && !(args.operation & (REFLECT_MODULE | COMPILE_FILE | EXPORT_BYTECODE_REPORT))) {
+			if (args.operation & EXPORT_SYMBOL_INDEX) {
+				symbols.Write(args.symbolIndexOutput.c_str());
+			}
+			return 0;
+		}
+
 		//build script
 		CScriptBuilder builder;
 		IncludeHandler includer;
+		IncludeHandler* includerPtr = nullptr;
 		if (!args.includeHandler.empty()) {
 			SetupIncludeHandler(args.includeHandler, includer);
-			builder.SetIncludeCallback(CustomInclude, &includer);
-		}
-		r = builder.StartNewModule(engine, args.sourceFile.c_str());
-		r = builder.AddSectionFromFile(args.sourceFile.c_str());
-		
-		//TODO: Add defines and include dirs
-		//This will compile the file and "print" any errors into the message list
-		r = builder.BuildModule();
+			includerPtr = &includer;
+		}
+		//TODO: Add include dirs
+		//stream diagnostics while compiling, only stop early when nothing else has to be written after them
+		DiagnosticsWriter diagnostics(args.maxErrors, !(args.operation & (REFLECT_MODULE | EXPORT_SYMBOL_INDEX | EXPORT_BYTECODE_REPORT)));
+		if (args.operation & COMPILE_FILE) {
+			diagnostics.Json().StartObject();
+			diagnostics.BeginMessages();
+			g_Diagnostics = &diagnostics;
+		}
+		int r = BuildScript(engine, includerPtr, args.sourceFile, args.defines, builder);
+		g_Diagnostics = nullptr;
 		asIScriptModule* module = builder.GetModule();
 		//Perform operation
 		if (args.operation & COMPILE_FILE) {
-			FormatAndPrintMessages();
+			diagnostics.EndMessages();
+			diagnostics.Json().EndObject();
+			diagnostics.Flush();
 		}
 		//only export module reflection if the compile succeeds
 		if (r >= 0 && args.operation & REFLECT_MODULE) {
-			AngelScriptExporter::ExportModuleAsJSON(args.output.c_str(), module, engine);
+			if (args.shardReflection) {
+				AngelScriptExporter::ExportModuleAsShards(args.output.c_str(), module, engine);
+			} else {
+				AngelScriptExporter::ExportModuleAsJSON(args.output.c_str(), module, engine);
+			}
+		}
+		//the module symbols are only added if the compile succeeds
+		if (args.operation & EXPORT_SYMBOL_INDEX) {
+			if (r >= 0) {
+				symbols.AddModule(module);
+			}
+			symbols.Write(args.symbolIndexOutput.c_str());
+		}
+		if (r >= 0 && args.operation & EXPORT_BYTECODE_REPORT) {
+			AngelScriptExporter::BytecodeReport report;
+			report.AddModule(module);
+			if (!args.debugDumps.empty()) {
+				AddDebugDumps(args.debugDumps, report);
+			}
+			report.Write(args.bytecodeReportOutput.c_str());
 		}
 	} else {
 		printf("%s\n", error.c_str());
@@ -1,11 +1,10 @@
 #include "asif_dynamic_config.h"
 #include <angelscript.h>
 
+#include "config_files.h"
 #include "dynamic_config_value.h"
 #include "parse_simplified_json.h"
-
-#include <fstream>
-#include <sstream>
+#include "scriptarray.h"
 
 using namespace AngelScript;
 
@@ -14,22 +13,55 @@ namespace stingray {
 	struct ScriptConfig {
 		ScriptConfig(): _ref_counter(0), dcv(){}
 
-		bool parse_file(std::string file) {
-			std::ifstream t(file.c_str());
-			std::stringstream buffer;
-			buffer << t.rdbuf();
-			return parse_string(buffer.str());
+		//the file is read and parsed in place, the strings of the config point into the read buffer.
+		//it isn't mapped, as the script can keep the config and a mapping would stop the file from being saved
+		bool parse_file(const std::string& file) {
+			sjson::ParseError parseError;
+			const char* error = config_files::parse_file(file.c_str(), dcv, parseError);
+			_error = error ? error : "";
+			return error == nullptr;
 		}
 
-		bool parse_string(std::string str) {
-			Buffer buf;
-			buf.len = str.size();
-			buf.p = &str[0];
+		bool parse_string(const std::string& str) {
+			Buffer buf(str.c_str(), (unsigned)str.size());
 			const char* error = sjson::parse(buf, dcv);
-			//TODO: print error
+			_error = error ? error : "";
 			return error == nullptr;
 		}
 
+		//parses the matching files in parallel into an object with the paths as keys, files that fail are left out.
+		//like parse_file the files are read rather than mapped
+		bool parse_files(const std::string& path, bool recursive) {
+			std::map<std::string, DynamicConfigValue> configs;
+			std::vector<config_files::LoadError> errors;
+			bool ok = config_files::load(path.c_str(), configs, &errors, recursive, 0, false);
+			dcv.set_empty_object();
+			for (auto& config : configs) {
+				dcv[config.first.c_str()] = std::move(config.second);
+			}
+			_error.clear();
+			for (auto& e : errors) {
+				_error += e.path + ": " + e.message + "\n";
+			}
+			return ok;
+		}
+
+		std::string error() {
+			return _error;
+		}
+
+		CScriptArray* keys() {
+			asIScriptContext* ctx = asGetActiveContext();
+			asITypeInfo* type = ctx->GetEngine()->GetTypeInfoByDecl("array<string>");
+			CScriptArray* keys = CScriptArray::Create(type, dcv.num_keys());
+			const DynamicConfigValue& value = dcv;
+			asUINT i = 0;
+			for (auto it = value.begin(); it != value.end(); ++it) {
+				*(std::string*)keys->At(i++) = it.key();
+			}
+			return keys;
+		}
+
 		bool is_array() { return dcv.is_array(); }
 		bool is_bool() { return dcv.is_bool(); }
 		bool is_data() { return dcv.is_data(); }
@@ -59,14 +91,16 @@ namespace stingray {
 		ScriptConfig* index(uint32_t i) {
 			ScriptConfig* c = new ScriptConfig();
 			c->increment();
-			c->dcv = dcv[i];
+			//const lookup, the non-const one thaws a frozen value and adds missing keys
+			c->dcv = static_cast<const DynamicConfigValue&>(dcv)[i];
 			return c;
 		}
 
 		ScriptConfig* index(std::string s) {
 			ScriptConfig* c = new ScriptConfig();
 			c->increment();
-			c->dcv = dcv[s.c_str()];
+			//const lookup, the non-const one thaws a frozen value and adds missing keys
+			c->dcv = static_cast<const DynamicConfigValue&>(dcv)[s.c_str()];
 			return c;
 		}
 
@@ -86,6 +120,7 @@ namespace stingray {
 
 		DynamicConfigValue dcv;
 		int _ref_counter;
+		std::string _error; //of the last parse
 	};
 
 	ScriptConfig* ConstructScriptConfig() {
@@ -101,8 +136,10 @@ namespace stingray {
 			r = engine->RegisterObjectBehaviour("Config", asBEHAVE_ADDREF, "void f()", asMETHOD(ScriptConfig, increment), asCALL_THISCALL);
 			r = engine->RegisterObjectBehaviour("Config", asBEHAVE_RELEASE, "void f()", asMETHOD(ScriptConfig, release), asCALL_THISCALL);
 
-			r = engine->RegisterObjectMethod("Config", "bool parse_file(string f)", asMETHOD(ScriptConfig, parse_file), asCALL_THISCALL);
-			r = engine->RegisterObjectMethod("Config", "bool parse_string(string str)", asMETHOD(ScriptConfig, parse_string), asCALL_THISCALL);
+			r = engine->RegisterObjectMethod("Config", "bool parse_file(const string &in f)", asMETHOD(ScriptConfig, parse_file), asCALL_THISCALL);
+			r = engine->RegisterObjectMethod("Config", "bool parse_string(const string &in str)", asMETHOD(ScriptConfig, parse_string), asCALL_THISCALL);
+			r = engine->RegisterObjectMethod("Config", "bool parse_files(const string &in path, bool recursive = false)", asMETHOD(ScriptConfig, parse_files), asCALL_THISCALL);
+			r = engine->RegisterObjectMethod("Config", "string error()", asMETHOD(ScriptConfig, error), asCALL_THISCALL);
 
 			r = engine->RegisterObjectMethod("Config", "bool is_array()", asMETHOD(ScriptConfig, is_array), asCALL_THISCALL);
 			r = engine->RegisterObjectMethod("Config", "bool is_bool()", asMETHOD(ScriptConfig, is_bool), asCALL_THISCALL);
@@ -122,6 +159,7 @@ namespace stingray {
 
 			r = engine->RegisterObjectMethod("Config", "int size()", asMETHOD(ScriptConfig, size), asCALL_THISCALL);
 			r = engine->RegisterObjectMethod("Config", "bool has(string name)", asMETHOD(ScriptConfig, has), asCALL_THISCALL);
+			r = engine->RegisterObjectMethod("Config", "array<string>@ keys()", asMETHOD(ScriptConfig, keys), asCALL_THISCALL);
 
 			r = engine->RegisterObjectMethod("Config", "Config@ opIndex(uint i)", asMETHODPR(ScriptConfig, index, (uint32_t), ScriptConfig*), asCALL_THISCALL);
 			r = engine->RegisterObjectMethod("Config", "Config@ opIndex(string str)", asMETHODPR(ScriptConfig, index, (std::string), ScriptConfig*), asCALL_THISCALL);
@@ -0,0 +1,275 @@
+#include "config_files.h"
+#include "parse_simplified_json.h"
+
+#include <atomic>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+#if defined(_WIN32)
+	#include <Windows.h>
+#else
+	#include <dirent.h>
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace stingray {
+
+namespace config_files
+{
+	namespace {
+		bool has_wildcard(const char *s)
+		{
+			return strpbrk(s, "*?") != nullptr;
+		}
+
+		/// Glob matching of a file name, * matches any number of characters and ? a single one.
+		bool matches(const char *pattern, const char *name)
+		{
+			const char *star = nullptr;
+			const char *star_name = nullptr;
+			while (*name) {
+				if (*pattern == '*') {
+					star = pattern++;
+					star_name = name;
+				} else if (*pattern == '?' || *pattern == *name) {
+					++pattern;
+					++name;
+				} else if (star) {
+					pattern = star + 1;
+					name = ++star_name;
+				} else {
+					return false;
+				}
+			}
+			while (*pattern == '*')
+				++pattern;
+			return *pattern == 0;
+		}
+
+		bool matches_default(const char *name)
+		{
+			return matches("*.config", name) || matches("*.sjson", name);
+		}
+
+		bool is_directory(const std::string &path)
+		{
+		#if defined(_WIN32)
+			DWORD attributes = GetFileAttributesA(path.c_str());
+			return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+		#else
+			struct stat st;
+			return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+		#endif
+		}
+
+		/// Calls f(name, is_directory) for the entries of dir, which ends with a separator.
+		template<typename F>
+		void list(const std::string &dir, F f)
+		{
+		#if defined(_WIN32)
+			WIN32_FIND_DATAA data;
+			HANDLE find = FindFirstFileA((dir + "*").c_str(), &data);
+			if (find == INVALID_HANDLE_VALUE)
+				return;
+			do {
+				if (strcmp(data.cFileName, ".") != 0 && strcmp(data.cFileName, "..") != 0)
+					f(data.cFileName, (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0);
+			} while (FindNextFileA(find, &data));
+			FindClose(find);
+		#else
+			DIR *d = opendir(dir.empty() ? "." : dir.c_str());
+			if (!d)
+				return;
+			while (dirent *entry = readdir(d)) {
+				if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0)
+					f(entry->d_name, is_directory(dir + entry->d_name));
+			}
+			closedir(d);
+		#endif
+		}
+
+		void find_in(const std::string &dir, const char *pattern, bool recursive, std::vector<std::string> &files)
+		{
+			std::vector<std::string> subdirs;
+			list(dir, [&](const char *name, bool directory) {
+				if (directory) {
+					if (recursive)
+						subdirs.push_back(dir + name + "/");
+				} else if (pattern ? matches(pattern, name) : matches_default(name)) {
+					files.push_back(dir + name);
+				}
+			});
+			for (const std::string &subdir : subdirs)
+				find_in(subdir, pattern, recursive, files);
+		}
+	}
+
+	MappedFile *MappedFile::open(const char *path, bool map)
+	{
+		MappedFile *file = new MappedFile();
+	#if defined(_WIN32)
+		HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (handle == INVALID_HANDLE_VALUE) {
+			delete file;
+			return nullptr;
+		}
+		LARGE_INTEGER size;
+		GetFileSizeEx(handle, &size);
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		const size_t page_size = info.dwPageSize;
+		file->_size = unsigned(size.QuadPart);
+		if (map && file->_size % page_size != 0) {
+			HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+			if (mapping) {
+				file->_data = (char *)MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+				file->_mapped = file->_data != nullptr;
+				// The view keeps the mapping alive
+				CloseHandle(mapping);
+			}
+		}
+		if (!file->_mapped) {
+			file->_copy.resize(size_t(file->_size) + 1);
+			DWORD read = 0;
+			if (file->_size)
+				ReadFile(handle, file->_copy.data(), file->_size, &read, nullptr);
+			file->_size = read;
+			file->_copy[read] = 0;
+			file->_data = file->_copy.data();
+		}
+		CloseHandle(handle);
+	#else
+		int fd = ::open(path, O_RDONLY);
+		if (fd < 0) {
+			delete file;
+			return nullptr;
+		}
+		struct stat st;
+		fstat(fd, &st);
+		const size_t page_size = size_t(sysconf(_SC_PAGESIZE));
+		file->_size = unsigned(st.st_size);
+		if (map && file->_size % page_size != 0) {
+			void *p = mmap(nullptr, file->_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+			file->_mapped = p != MAP_FAILED;
+			if (file->_mapped)
+				file->_data = (char *)p;
+		}
+		if (!file->_mapped) {
+			file->_copy.resize(size_t(file->_size) + 1);
+			ssize_t n = file->_size ? read(fd, file->_copy.data(), file->_size) : 0;
+			file->_size = n > 0 ? unsigned(n) : 0;
+			file->_copy[file->_size] = 0;
+			file->_data = file->_copy.data();
+		}
+		::close(fd);
+	#endif
+		return file;
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (!_mapped)
+			return;
+	#if defined(_WIN32)
+		UnmapViewOfFile(_data);
+	#else
+		munmap(_data, _size);
+	#endif
+	}
+
+	const char *parse_file(const char *path, DynamicConfigValue &value, sjson::ParseError &error, bool map)
+	{
+		MappedFile *file = MappedFile::open(path, map);
+		if (!file) {
+			snprintf(error.message, sizeof(error.message), "Could not open %s", path);
+			return error.message;
+		}
+		// Only keys and containers are allocated, the strings stay in the file
+		ConfigArena *arena = ConfigArena::create(file->size() / 2);
+		arena->add_finalizer([](void *data) {delete (MappedFile *)data;}, file);
+		return sjson::parse_in_place(Buffer(file->data(), file->size()), value, error, *arena);
+	}
+
+	void find(const char *path, bool recursive, std::vector<std::string> &files)
+	{
+		std::string dir = path;
+		std::string pattern;
+		if (!is_directory(dir)) {
+			size_t slash = dir.find_last_of("/\\");
+			pattern = slash == std::string::npos ? dir : dir.substr(slash + 1);
+			dir = slash == std::string::npos ? "" : dir.substr(0, slash + 1);
+			if (!has_wildcard(pattern.c_str())) {
+				// A single file
+				if (!recursive) {
+					files.push_back(path);
+					return;
+				}
+			}
+		} else if (!dir.empty() && dir.back() != '/' && dir.back() != '\\') {
+			dir += "/";
+		}
+		find_in(dir, pattern.empty() ? nullptr : pattern.c_str(), recursive, files);
+	}
+
+	bool load(const std::vector<std::string> &files, std::map<std::string, DynamicConfigValue> &configs,
+		std::vector<LoadError> *errors, unsigned threads, bool map_files)
+	{
+		struct Result {
+			DynamicConfigValue value;
+			std::string error;
+		};
+		std::vector<Result> results(files.size());
+		std::atomic<size_t> next(0);
+
+		auto worker = [&]() {
+			sjson::ParseError parse_error;
+			for (size_t i = next++; i < files.size(); i = next++) {
+				if (parse_file(files[i].c_str(), results[i].value, parse_error, map_files))
+					results[i].error = parse_error.message;
+			}
+		};
+
+		unsigned thread_count = threads ? threads : std::thread::hardware_concurrency();
+		if (thread_count == 0)
+			thread_count = 1;
+		if (thread_count > files.size())
+			thread_count = unsigned(files.size());
+		if (thread_count <= 1) {
+			worker();
+		} else {
+			std::vector<std::thread> pool;
+			for (unsigned t = 0; t < thread_count; ++t)
+				pool.push_back(std::thread(worker));
+			for (std::thread &t : pool)
+				t.join();
+		}
+
+		bool ok = true;
+		for (size_t i = 0; i < files.size(); ++i) {
+			if (!results[i].error.empty()) {
+				ok = false;
+				if (errors) {
+					LoadError error = {files[i], results[i].error};
+					errors->push_back(error);
+				}
+				continue;
+			}
+			configs[files[i]] = std::move(results[i].value);
+		}
+		return ok;
+	}
+
+	bool load(const char *path, std::map<std::string, DynamicConfigValue> &configs,
+		std::vector<LoadError> *errors, bool recursive, unsigned threads, bool map_files)
+	{
+		std::vector<std::string> files;
+		find(path, recursive, files);
+		return load(files, configs, errors, threads, map_files);
+	}
+}
+
+} // namespace stingray
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "dynamic_config_value.h"
+#include "parse_simplified_json.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace stingray {
+
+/// Loading of many SJSON files at once, e.g. all the settings of a project at startup.
+namespace config_files
+{
+	/// A file that couldn't be read or parsed.
+	struct LoadError
+	{
+		std::string path;
+		std::string message;
+	};
+
+	/// A file mapped copy-on-write, so it can be parsed in place: writes only change the view of
+	/// this process and only the pages that are written get copied. data()[size()] is readable and 0.
+	/// Files whose size is a multiple of the page size (there is no zero padding after them) are
+	/// read into memory instead, as are all files when @p map is false.
+	/// On Windows the file can't be written or replaced while it is mapped.
+	class MappedFile
+	{
+	public:
+		/// Returns nullptr if the file can't be opened.
+		static MappedFile *open(const char *path, bool map = true);
+		~MappedFile();
+
+		char *data() const {return _data;}
+		unsigned size() const {return _size;}
+
+	private:
+		MappedFile() : _data(nullptr), _size(0), _mapped(false) {}
+		MappedFile(const MappedFile &) = delete;
+		void operator=(const MappedFile &) = delete;
+
+		char *_data;
+		unsigned _size;
+		bool _mapped;
+		std::vector<char> _copy;
+	};
+
+	/// Reads the file and parses it in place, the strings of @p value point into the file's buffer,
+	/// which stays alive as long as any value of the document does. With @p map the buffer is the
+	/// MappedFile's mapping, which saves the copy but keeps the file locked on Windows for as long,
+	/// so only map files whose values are dropped soon. Returns nullptr or error.message.
+	const char *parse_file(const char *path, DynamicConfigValue &value, sjson::ParseError &error, bool map = false);
+
+	/// Appends the files matching @p path to @p files. @p path is either a directory, which matches
+	/// its .config and .sjson files, or a pattern with * and ? in the file name like "settings/*.physics".
+	/// With @p recursive the subdirectories are searched for the same pattern as well.
+	void find(const char *path, bool recursive, std::vector<std::string> &files);
+
+	/// Reads and parses @p files on @p threads worker threads, 0 uses one per core. The configs
+	/// are stored under their path. Files that fail are left out of @p configs and added to @p errors.
+	/// The files are mapped unless @p map_files is false, see parse_file(), which suits loads whose
+	/// configs are converted and dropped. Returns false if any file failed.
+	bool load(const std::vector<std::string> &files, std::map<std::string, DynamicConfigValue> &configs,
+		std::vector<LoadError> *errors = nullptr, unsigned threads = 0, bool map_files = true);
+
+	/// Loads the files matching @p path, see find().
+	bool load(const char *path, std::map<std::string, DynamicConfigValue> &configs,
+		std::vector<LoadError> *errors = nullptr, bool recursive = false, unsigned threads = 0, bool map_files = true);
+}
+
+} // namespace stingray
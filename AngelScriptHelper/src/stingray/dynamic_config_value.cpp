@@ -1,6 +1,10 @@
 #include "dynamic_config_value.h"
 #include "parse_simplified_json.h"
 
+#include <algorithm>
+#include <new>
+#include <stdint.h>
+
 #ifdef CAN_COMPILE
 	namespace { stingray::logging::System CONFIG = { "Config" }; }
 #endif
@@ -13,6 +17,170 @@ namespace
 
 namespace stingray {
 
+ConfigArena *ConfigArena::create(size_t expected_size)
+{
+	return new ConfigArena(expected_size);
+}
+
+ConfigArena::ConfigArena(size_t chunk_size)
+	: _ref_count(0)
+	, _at(nullptr)
+	, _end(nullptr)
+	, _chunk_size(std::max<size_t>(chunk_size, 4096))
+	, _allocated(0)
+	, _keys(256)
+	, _num_keys(0)
+{
+}
+
+ConfigArena::~ConfigArena()
+{
+	// The values in the arena are never destroyed, frozen values don't own anything
+	for (char *chunk : _chunks)
+		delete[] chunk;
+	for (const Finalizer &finalizer : _finalizers)
+		finalizer.f(finalizer.data);
+}
+
+void ConfigArena::add_finalizer(void (*f)(void *), void *data)
+{
+	Finalizer finalizer = {f, data};
+	_finalizers.push_back(finalizer);
+}
+
+void *ConfigArena::allocate(size_t size, size_t align)
+{
+	char *p = (char *)(((uintptr_t)_at + align - 1) & ~(uintptr_t)(align - 1));
+	if (_at == nullptr || p + size > _end) {
+		size_t chunk_size = std::max(_chunk_size, size + align);
+		char *chunk = new char[chunk_size];
+		_chunks.push_back(chunk);
+		_allocated += chunk_size;
+		_at = chunk;
+		_end = chunk + chunk_size;
+		_chunk_size *= 2;
+		p = (char *)(((uintptr_t)_at + align - 1) & ~(uintptr_t)(align - 1));
+	}
+	_at = p + size;
+	return p;
+}
+
+namespace {
+	unsigned hash_key(const char *s, unsigned len)
+	{
+		// FNV-1a
+		unsigned h = 2166136261u;
+		for (unsigned i = 0; i < len; ++i)
+			h = (h ^ (unsigned char)s[i]) * 16777619u;
+		return h;
+	}
+}
+
+void ConfigArena::grow_keys()
+{
+	std::vector<Key> keys(_keys.size() * 2);
+	const unsigned mask = unsigned(keys.size() - 1);
+	for (const Key &key : _keys) {
+		if (!key.s)
+			continue;
+		unsigned i = key.hash & mask;
+		while (keys[i].s)
+			i = (i + 1) & mask;
+		keys[i] = key;
+	}
+	_keys.swap(keys);
+}
+
+const char *ConfigArena::intern(const char *s, unsigned len)
+{
+	if (2 * (_num_keys + 1) > _keys.size())
+		grow_keys();
+
+	const unsigned hash = hash_key(s, len);
+	const unsigned mask = unsigned(_keys.size() - 1);
+	unsigned i = hash & mask;
+	for (; _keys[i].s; i = (i + 1) & mask) {
+		const Key &key = _keys[i];
+		if (key.hash == hash && key.len == len && memcmp(key.s, s, len) == 0)
+			return key.s;
+	}
+
+	char *copy = (char *)allocate(len + 1, 1);
+	memcpy(copy, s, len);
+	copy[len] = 0;
+	_keys[i].hash = hash;
+	_keys[i].len = len;
+	_keys[i].s = copy;
+	++_num_keys;
+	return copy;
+}
+
+DynamicConfigValue DynamicConfigValue::make_frozen(ConfigArena &arena, ValueType type, unsigned size, void *data)
+{
+	Frozen *frozen = (Frozen *)arena.allocate(sizeof(Frozen));
+	frozen->arena = &arena;
+	frozen->size = size;
+	frozen->data = data;
+
+	DynamicConfigValue value;
+	value._type = type;
+	value._frozen = 1;
+	value._frozen_data = frozen;
+	return value;
+}
+
+DynamicConfigValue DynamicConfigValue::frozen_string(ConfigArena &arena, const char *s, unsigned len)
+{
+	char *copy = (char *)arena.allocate(len + 1, 1);
+	memcpy(copy, s, len);
+	copy[len] = 0;
+	return make_frozen(arena, STRING, len, copy);
+}
+
+DynamicConfigValue DynamicConfigValue::frozen_string_ref(ConfigArena &arena, const char *s, unsigned len)
+{
+	return make_frozen(arena, STRING, len, const_cast<char *>(s));
+}
+
+DynamicConfigValue DynamicConfigValue::frozen_array(ConfigArena &arena, DynamicConfigValue *items, unsigned size)
+{
+	DynamicConfigValue *copy = (DynamicConfigValue *)arena.allocate(size * sizeof(DynamicConfigValue), alignof(DynamicConfigValue));
+	for (unsigned i = 0; i < size; ++i)
+		new (copy + i) DynamicConfigValue(std::move(items[i]));
+	return make_frozen(arena, ARRAY, size, copy);
+}
+
+DynamicConfigValue DynamicConfigValue::frozen_object(ConfigArena &arena, const char **keys, DynamicConfigValue *values, unsigned size, const char **duplicate_key)
+{
+	Member *members = (Member *)arena.allocate(size * sizeof(Member), alignof(Member));
+	for (unsigned i = 0; i < size; ++i) {
+		new (members + i) Member();
+		members[i].key = keys[i];
+		members[i].value = std::move(values[i]);
+	}
+	// Sorted like the keys of a Map, so lookups are a binary search and iteration order doesn't change
+	std::sort(members, members + size, [](const Member &a, const Member &b) {return strcmp(a.key, b.key) < 0;});
+
+	*duplicate_key = nullptr;
+	for (unsigned i = 1; i < size; ++i) {
+		// Interned keys are equal if their pointers are
+		if (members[i].key == members[i - 1].key) {
+			*duplicate_key = members[i].key;
+			break;
+		}
+	}
+	return make_frozen(arena, OBJECT, size, members);
+}
+
+void DynamicConfigValue::adopt(DynamicConfigValue &&root)
+{
+	*this = std::move(root);
+	if (_frozen && !_owner) {
+		_frozen_data->arena->add_ref();
+		_owner = 1;
+	}
+}
+
 void DynamicConfigValue::find(const char *key, std::vector<DynamicConfigValue> &found) const
 {
 	if (is_object()) {
@@ -51,7 +219,7 @@ const char *DynamicConfigValue::to_resource_unsafe(const char *type, ReferenceFo
 	assert(is_resource(type, rf));
 	if (rf == ReferenceFormat::BOTH && is_string()) {
 		// logging::warning(CONFIG, eprintf("Old resource reference `%s`: `%s`.", type, to_string_unsafe()));
-		auto s = _data->data();
+		auto s = const_cast<char *>(string_data());
 		auto dot = strchr(s, '.');
 		if (dot)
 			*dot = 0;
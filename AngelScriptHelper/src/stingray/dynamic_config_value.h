@@ -9,6 +9,8 @@
 */
 
 #include <assert.h>
+#include <string.h>
+#include <atomic>
 #include <vector>
 #include <string>
 #include <map>
@@ -23,11 +25,68 @@ enum class ReferenceFormat
 	TABLE 		///< Only allow the new table reference format.
 };
 
+/// Bump allocator that holds the strings, arrays and objects of a parsed document, so that
+/// parsing a document only allocates a few large chunks instead of every node separately.
+/// Object keys are interned, every distinct key is only stored once per document.
+/// The values that point into the arena keep it alive through its reference count.
+class ConfigArena
+{
+public:
+	/// Creates an arena with a reference count of zero. The first chunk is sized from
+	/// the expected number of bytes, later chunks grow geometrically.
+	static ConfigArena *create(size_t expected_size = 0);
+
+	void add_ref() {++_ref_count;}
+	void release() {if (--_ref_count == 0) delete this;}
+
+	void *allocate(size_t size, size_t align = sizeof(void *));
+	/// Returns the interned, null terminated copy of the len first characters of s.
+	const char *intern(const char *s, unsigned len);
+	/// Calls f(data) when the arena is destroyed, e.g. to release a buffer that values point into.
+	void add_finalizer(void (*f)(void *), void *data);
+
+	unsigned num_chunks() const {return (unsigned)_chunks.size();}
+	size_t allocated() const {return _allocated;}
+
+private:
+	ConfigArena(size_t chunk_size);
+	~ConfigArena();
+	ConfigArena(const ConfigArena &) = delete;
+	void operator=(const ConfigArena &) = delete;
+
+	void grow_keys();
+
+	struct Finalizer {
+		void (*f)(void *);
+		void *data;
+	};
+
+	struct Key {
+		unsigned hash;
+		unsigned len;
+		const char *s;
+	};
+
+	std::atomic<unsigned> _ref_count;
+	std::vector<char *> _chunks;
+	char *_at;
+	char *_end;
+	size_t _chunk_size;
+	size_t _allocated;
+	std::vector<Key> _keys;
+	unsigned _num_keys;
+	std::vector<Finalizer> _finalizers;
+};
+
 /// Represents a "dynamic" config data item, i.e. once that can be modified during
 /// runtime. Dynamic config data items uses regular maps() and vectors() to store
 /// the data, rather than storing everything in a single memory block. They are
 /// therefore considerably less efficient than the const config data items. For that
 /// reason, you should use const config data items wherever possible.
+///
+/// Values parsed by sjson::parse() are "frozen": their strings, arrays and objects live in a
+/// ConfigArena shared by the whole document, copying them only copies a reference, and they are
+/// converted to the regular representation one level at a time when they are first modified.
 class DynamicConfigValue
 {
 public:
@@ -39,11 +98,11 @@ public:
 		const char *name;
 	};
 
-	DynamicConfigValue() : _type(NIL), _tag(0), _data(nullptr), _array(nullptr), _object(nullptr){}
+	DynamicConfigValue() : _type(NIL), _tag(0), _frozen(0), _owner(0), _object(nullptr) {}
 	~DynamicConfigValue();
 
 	DynamicConfigValue(const DynamicConfigValue &o);
-	DynamicConfigValue(DynamicConfigValue &&o);
+	DynamicConfigValue(DynamicConfigValue &&o) noexcept;
 	void operator=(const DynamicConfigValue &o);
 	void operator=(DynamicConfigValue &&o);
 
@@ -74,15 +133,18 @@ public:
 	bool is_data() const	{return _type == DATA;}
 	bool is_array() const 	{return _type == ARRAY;}
 	bool is_object() const 	{return _type == OBJECT;}
+	bool is_frozen() const	{return _frozen;}
 
 	/// Unsafe conversion functions. These will crash the engine if the object is not of the right type.
 	/// You should only use these when you KNOW that the object is of the right type.
 	bool to_bool_unsafe() const					{assert(is_bool()); 	return _bool;}
 	int to_integer_unsafe() const				{assert(is_integer()); return _integer;}
 	float to_float_unsafe()  const				{						return is_float() ? _float : float(to_integer_unsafe());}
-	const char *to_string_unsafe() const		{assert(is_string()); 	return _data->data();}
-	const char *to_string_unsafe(unsigned& sz) const { assert(is_string()); return sz = _data->size() - 1, _data->data(); }
-	const std::vector<char> &to_string_data_unsafe() const { assert(is_string()); return *_data; }
+	const char *to_string_unsafe() const		{assert(is_string()); 	return string_data();}
+	const char *to_string_unsafe(unsigned& sz) const { assert(is_string()); return sz = string_size(), string_data(); }
+	/// For old style "name.type" strings the '.' is overwritten with a terminator in place. The string
+	/// data is shared by every copy of a frozen document and may be the view of a mapped file, see
+	/// config_files::parse_file(), so all of them see the shortened string afterwards.
 	const char *to_resource_unsafe(const char *type, ReferenceFormat rf = ReferenceFormat::BOTH) const;
 	const std::vector<char> &to_data_unsafe() const	{ assert(is_data()); 	return *_data; }
 
@@ -91,7 +153,7 @@ public:
 	bool to_bool(bool &e) const					{if (is_bool()) return _bool;				e=true; return false;}
 	int to_integer(bool &e) const				{if (is_integer()) return _integer;			e=true; return 0;}
 	float to_float(bool &e)  const				{if (is_float()) return _float;				return float(to_integer(e));}
-	const char *to_string(bool &e) const		{if (is_string()) return _data->data();	e=true; return "";}
+	const char *to_string(bool &e) const		{if (is_string()) return string_data();	e=true; return "";}
 	const char *to_resource(const char *type, bool &e, ReferenceFormat rf = ReferenceFormat::BOTH) const;
 	const std::vector<char> *to_data() const {
 		if (is_data()) 
@@ -123,7 +185,7 @@ public:
 		}
 		const char *to_string(ErrorState &e) const
 		{
-			if (is_string()) return _data->begin();
+			if (is_string()) return string_data();
 			set_error(e, "Expected a string");
 			return "expected a string";
 		}
@@ -167,7 +229,7 @@ public:
 		const char *get_string(const char *key, ErrorState &e) const
 		{
 			const DynamicConfigValue &child = (*this)[key];
-			if (child.is_string()) return child._data->begin();
+			if (child.is_string()) return child.string_data();
 			set_error(e, key, "Expected a string");
 			return "expected a string";
 		}
@@ -201,25 +263,13 @@ public:
 
 	bool equals_string(const char *s) const             {return is_string() && strcmp(to_string_unsafe(), s) == 0;}
 
-	unsigned size() const {return is_array() ?  _array->size() : 0;}
+	unsigned size() const {return is_array() ? (_frozen ? _frozen_data->size : unsigned(_array->size())) : 0;}
 	const DynamicConfigValue &operator[](int i) const {return (*this)[unsigned(i)];}
-	const DynamicConfigValue &operator[](unsigned i) const {
-		if (!is_array() || i >= size())
-			return static_nil();
-		else
-			return (*_array)[i];
-	}
+	const DynamicConfigValue &operator[](unsigned i) const;
 
-	unsigned num_keys() const {return is_object() ? _object->size() : 0;}
-	const DynamicConfigValue &operator[](const char *s) const {
-		if (!is_object() || !(_object->find(s) != _object->end()))
-			return static_nil();
-		else
-			return (*_object)[s];
-	}
-	bool has(const char *s) const {
-		return is_object() && (_object->find(s) != _object->end());
-	}
+	unsigned num_keys() const {return is_object() ? (_frozen ? _frozen_data->size : unsigned(_object->size())) : 0;}
+	const DynamicConfigValue &operator[](const char *s) const;
+	bool has(const char *s) const;
 
 	static const DynamicConfigValue& static_nil()
 	{
@@ -228,10 +278,11 @@ public:
 	}
 
 	typedef std::map<std::string, DynamicConfigValue> Map;
+	struct Member;
 
 	class iterator {
 	public:
-		iterator() : _it(nullptr, 0) {}
+		iterator() : _it() {}
 		iterator(Map::iterator it) : _it(it) {}
 		void operator++() {++_it;}
 		const char *key() {return _it->first.c_str();}
@@ -244,15 +295,16 @@ public:
 
 	class const_iterator {
 	public:
-		const_iterator() : _it(nullptr, 0) {}
-		const_iterator(Map::const_iterator it) : _it(it) {}
-		void operator++() {++_it;}
-		const char *key() {return _it->first.c_str();}
-		const DynamicConfigValue &value() {return _it->second;}
-		const Map::value_type &operator*() { return *_it; }
-		bool operator!=(const const_iterator &it) const {return _it != it._it;}
+		const_iterator() : _it(), _member(nullptr) {}
+		const_iterator(Map::const_iterator it) : _it(it), _member(nullptr) {}
+		const_iterator(const Member *member) : _it(), _member(member) {}
+		void operator++();
+		const char *key();
+		const DynamicConfigValue &value();
+		bool operator!=(const const_iterator &it) const {return _member != it._member || (!_member && _it != it._it);}
 	private:
 		Map::const_iterator _it;
+		const Member *_member;
 	};
 
 	const_iterator begin() const;
@@ -290,6 +342,19 @@ public:
 
 	DynamicConfigValue &push();
 
+	/// Construction of frozen values, for parsers. The values don't hold a reference to the arena, they
+	/// should only be stored in arrays and objects of the same arena or passed to adopt().
+	static DynamicConfigValue frozen_string(ConfigArena &arena, const char *s, unsigned len);
+	/// Refers to s instead of copying it, s has to be null terminated and outlive the arena.
+	static DynamicConfigValue frozen_string_ref(ConfigArena &arena, const char *s, unsigned len);
+	/// Moves the items into the arena.
+	static DynamicConfigValue frozen_array(ConfigArena &arena, DynamicConfigValue *items, unsigned size);
+	/// Moves the values into the arena. The keys have to be interned in the same arena,
+	/// if a key occurs more than once it is returned in duplicate_key.
+	static DynamicConfigValue frozen_object(ConfigArena &arena, const char **keys, DynamicConfigValue *values, unsigned size, const char **duplicate_key);
+	/// Takes over a value created by the frozen_ functions and the root of the document from now on.
+	void adopt(DynamicConfigValue &&root);
+
 private:
 	#ifdef CAN_COMPILE
 		void set_error(ErrorState &es, const char *msg) const;
@@ -299,23 +364,47 @@ private:
 
 	enum ValueType {NIL, BOOL, INTEGER, FLOAT, STRING, DATA, ARRAY, OBJECT};
 
+	/// Header of the strings, arrays and objects in an arena. data points at the characters,
+	/// the DynamicConfigValue items or the Member items, objects are sorted on their keys.
+	struct Frozen {
+		ConfigArena *arena;
+		unsigned size;
+		void *data;
+	};
+
 	struct {
 		unsigned _type : TYPE_BITS;
 		unsigned _tag : TAG_BITS;
+		unsigned _frozen : 1;	///< The data is in an arena
+		unsigned _owner : 1;	///< The value holds a reference to the arena
 	};
 
 	union {
 		Map *_object = nullptr;
 		std::vector<DynamicConfigValue> *_array;
 		std::vector<char> *_data;
+		Frozen *_frozen_data;
 		float _float;
 		int _integer;
 		bool _bool;
 	};
 
+	const char *string_data() const {return _frozen ? (const char *)_frozen_data->data : _data->data();}
+	unsigned string_size() const {return _frozen ? _frozen_data->size : unsigned(_data->size() - 1);}
+	const Member *find_member(const char *s) const;
+	static DynamicConfigValue make_frozen(ConfigArena &arena, ValueType type, unsigned size, void *data);
+
+	void copy(const DynamicConfigValue &o);
+	void thaw();
 	void destroy();
 };
 
+struct DynamicConfigValue::Member
+{
+	const char *key;
+	DynamicConfigValue value;
+};
+
 } // namespace stingray
 
 #include "dynamic_config_value.inl"
@@ -1,9 +1,19 @@
 namespace stingray {
 
-inline DynamicConfigValue::DynamicConfigValue(const DynamicConfigValue &o)
+inline void DynamicConfigValue::copy(const DynamicConfigValue &o)
 {
 	_type = o._type;
 	_tag = o._tag;
+	_frozen = o._frozen;
+	_owner = 0;
+
+	if (_frozen) {
+		// Frozen data is never modified, so copies share it
+		_frozen_data = o._frozen_data;
+		_frozen_data->arena->add_ref();
+		_owner = 1;
+		return;
+	}
 
 	switch (_type) {
 		case NIL: break;
@@ -25,9 +35,16 @@ inline DynamicConfigValue::DynamicConfigValue(const DynamicConfigValue &o)
 	}
 }
 
-inline DynamicConfigValue::DynamicConfigValue(DynamicConfigValue &&o)
+inline DynamicConfigValue::DynamicConfigValue(const DynamicConfigValue &o)
+{
+	copy(o);
+}
+
+inline DynamicConfigValue::DynamicConfigValue(DynamicConfigValue &&o) noexcept
 	: _type(o._type)
 	, _tag(o._tag)
+	, _frozen(o._frozen)
+	, _owner(o._owner)
 {
 	switch (_type) {
 		case NIL:
@@ -43,52 +60,35 @@ inline DynamicConfigValue::DynamicConfigValue(DynamicConfigValue &&o)
 			break;
 		case STRING:
 		case DATA:
-			_data = o._data;
-			break;
 		case ARRAY:
-			_array = o._array;
-			break;
 		case OBJECT:
 			_object = o._object;
 			break;
 	}
 	o._type = NIL;
 	o._tag = 0;
+	o._frozen = 0;
+	o._owner = 0;
 }
 
 inline void DynamicConfigValue::operator=(const DynamicConfigValue &o)
 {
+	if (&o == this)
+		return;
 	destroy();
-
-	_type = o._type;
-	_tag = o._tag;
-
-	switch (_type) {
-		case NIL: break;
-		case BOOL: _bool = o._bool; break;
-		case INTEGER: _integer = o._integer; break;
-		case FLOAT: _float = o._float; break;
-		case STRING: case DATA:
-			_data = new std::vector<char>();
-			*_data = *o._data;
-			break;
-		case ARRAY:
-			_array = new std::vector<DynamicConfigValue>();
-			*_array = *o._array;
-			break;
-		case OBJECT:
-			_object = new Map();
-			*_object = *o._object;
-			break;
-	}
+	copy(o);
 }
 
 inline void DynamicConfigValue::operator=(DynamicConfigValue &&o)
 {
+	if (&o == this)
+		return;
 	destroy();
 
 	_type = o._type;
 	_tag = o._tag;
+	_frozen = o._frozen;
+	_owner = o._owner;
 
 	switch (_type) {
 		case NIL:
@@ -104,17 +104,15 @@ inline void DynamicConfigValue::operator=(DynamicConfigValue &&o)
 			break;
 		case STRING:
 		case DATA:
-			_data = o._data;
-			break;
 		case ARRAY:
-			_array = o._array;
-			break;
 		case OBJECT:
 			_object = o._object;
 			break;
 	}
 	o._type = NIL;
 	o._tag = 0;
+	o._frozen = 0;
+	o._owner = 0;
 }
 
 inline DynamicConfigValue::~DynamicConfigValue()
@@ -124,15 +122,101 @@ inline DynamicConfigValue::~DynamicConfigValue()
 
 inline void DynamicConfigValue::destroy()
 {
-	if (_type == STRING || _type == DATA)
-		if(_data) delete _data;
-	else if (_type == ARRAY)
-		if (_array) delete _array;
-	else if (_type == OBJECT)
-		if (_object) delete _object;
+	if (_frozen) {
+		if (_owner)
+			_frozen_data->arena->release();
+	} else if (_type == STRING || _type == DATA) {
+		delete _data;
+	} else if (_type == ARRAY) {
+		delete _array;
+	} else if (_type == OBJECT) {
+		delete _object;
+	}
 	_type = NIL;
+	_frozen = 0;
+	_owner = 0;
+}
+
+/// Converts a frozen value to the regular representation before it is modified. The children
+/// stay frozen, they are copies that share the arena until they are modified themselves.
+inline void DynamicConfigValue::thaw()
+{
+	if (!_frozen)
+		return;
+
+	Frozen *frozen = _frozen_data;
+	bool owner = _owner;
+	switch (_type) {
+		case STRING: {
+			const char *s = (const char *)frozen->data;
+			_data = new std::vector<char>(s, s + frozen->size + 1);
+			break;
+		}
+		case ARRAY: {
+			DynamicConfigValue *items = (DynamicConfigValue *)frozen->data;
+			_array = new std::vector<DynamicConfigValue>(items, items + frozen->size);
+			break;
+		}
+		case OBJECT: {
+			Member *members = (Member *)frozen->data;
+			_object = new Map();
+			for (unsigned i = 0; i < frozen->size; ++i)
+				_object->emplace_hint(_object->end(), members[i].key, members[i].value);
+			break;
+		}
+	}
+	_frozen = 0;
+	_owner = 0;
+	if (owner)
+		frozen->arena->release();
 }
 
+inline const DynamicConfigValue::Member *DynamicConfigValue::find_member(const char *s) const
+{
+	const Member *members = (const Member *)_frozen_data->data;
+	unsigned lo = 0, hi = _frozen_data->size;
+	while (lo < hi) {
+		unsigned mid = (lo + hi) / 2;
+		int c = strcmp(members[mid].key, s);
+		if (c == 0)
+			return members + mid;
+		if (c < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return nullptr;
+}
+
+inline const DynamicConfigValue &DynamicConfigValue::operator[](unsigned i) const
+{
+	if (!is_array() || i >= size())
+		return static_nil();
+	if (_frozen)
+		return ((const DynamicConfigValue *)_frozen_data->data)[i];
+	return (*_array)[i];
+}
+
+inline const DynamicConfigValue &DynamicConfigValue::operator[](const char *s) const
+{
+	if (!is_object())
+		return static_nil();
+	if (_frozen) {
+		const Member *member = find_member(s);
+		return member ? member->value : static_nil();
+	}
+	Map::const_iterator it = _object->find(s);
+	return it != _object->end() ? it->second : static_nil();
+}
+
+inline bool DynamicConfigValue::has(const char *s) const
+{
+	if (!is_object())
+		return false;
+	if (_frozen)
+		return find_member(s) != nullptr;
+	return _object->find(s) != _object->end();
+}
 
 inline void DynamicConfigValue::set_nil()
 {
@@ -179,8 +263,7 @@ inline void DynamicConfigValue::set_string(const char *s)
 	destroy();
 	if (s == nullptr) {
 		_type = STRING;
-		_data = new std::vector<char>();
-		(*_data)[0] = '\0';
+		_data = new std::vector<char>(1, '\0');
 		return;
 	}
 	const unsigned string_len = strlen(s);
@@ -217,6 +300,7 @@ inline DynamicConfigValue & DynamicConfigValue::operator[](unsigned i)
 		assert(is_nil());
 		set_empty_array();
 	}
+	thaw();
 	if (i >= size())
 		_array->resize(i+1);
 	return (*_array)[i];
@@ -228,7 +312,7 @@ inline unsigned DynamicConfigValue::num_keys()
 		assert(is_nil());
 		return 0;
 	}
-	return _object->size();
+	return _frozen ? _frozen_data->size : unsigned(_object->size());
 }
 
 inline DynamicConfigValue & DynamicConfigValue::operator[](const char *s)
@@ -237,6 +321,7 @@ inline DynamicConfigValue & DynamicConfigValue::operator[](const char *s)
 		assert(is_nil());
 		set_empty_object();
 	}
+	thaw();
 	return (*_object)[s];
 }
 
@@ -246,33 +331,67 @@ inline DynamicConfigValue & DynamicConfigValue::push()
 		assert(is_nil());
 		set_empty_array();
 	}
+	thaw();
 	_array->push_back( DynamicConfigValue() );
 	return _array->back();
 }
 
 inline DynamicConfigValue::iterator DynamicConfigValue::begin()
 {
-	return is_object() ? iterator(_object->begin()) : iterator();
+	if (!is_object())
+		return iterator();
+	thaw();
+	return iterator(_object->begin());
 }
 
 inline DynamicConfigValue::iterator DynamicConfigValue::end()
 {
-	return is_object() ? iterator(_object->end()) : iterator();
+	if (!is_object())
+		return iterator();
+	thaw();
+	return iterator(_object->end());
 }
 
 inline DynamicConfigValue::const_iterator DynamicConfigValue::begin() const
 {
-	return is_object() ? const_iterator(_object->begin()) : const_iterator();
+	if (!is_object())
+		return const_iterator();
+	if (_frozen)
+		return const_iterator((const Member *)_frozen_data->data);
+	return const_iterator(_object->begin());
 }
 
 inline DynamicConfigValue::const_iterator DynamicConfigValue::end() const
 {
-	return is_object() ? const_iterator(_object->end()) : const_iterator();
+	if (!is_object())
+		return const_iterator();
+	if (_frozen)
+		return const_iterator((const Member *)_frozen_data->data + _frozen_data->size);
+	return const_iterator(_object->end());
+}
+
+inline void DynamicConfigValue::const_iterator::operator++()
+{
+	if (_member)
+		++_member;
+	else
+		++_it;
+}
+
+inline const char *DynamicConfigValue::const_iterator::key()
+{
+	return _member ? _member->key : _it->first.c_str();
+}
+
+inline const DynamicConfigValue &DynamicConfigValue::const_iterator::value()
+{
+	return _member ? _member->value : _it->second;
 }
 
 inline void DynamicConfigValue::remove_key(const char *s)
 {
 	assert(is_object());
+	thaw();
 	assert(_object->find(s) != _object->end());
 	_object->erase(s);
 }
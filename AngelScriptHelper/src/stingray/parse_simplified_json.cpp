@@ -2,16 +2,25 @@
 
 #include <math.h>
 #include <stdio.h>
-#include <setjmp.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "dynamic_config_value.h"
 
-#if defined(PS4) || defined(LINUXPC) || defined(_GAMING_XBOX)
-	#define omp_get_thread_num()	0
-#else
-	#include <omp.h>
+// The scanners below look at 32 (AVX2) or 16 (SSE2) bytes at a time when the compiler targets those
+// instruction sets, define SJSON_NO_SIMD to build the scalar versions only.
+#if !defined(SJSON_NO_SIMD) && defined(__AVX2__)
+	#define SJSON_SIMD
+	#include <immintrin.h>
+#elif !defined(SJSON_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+	#define SJSON_SIMD
+	#include <emmintrin.h>
+#endif
+
+#if defined(SJSON_SIMD) && defined(_MSC_VER)
+	#include <intrin.h>
 #endif
 
 namespace {
@@ -42,21 +51,169 @@ namespace {
 		return utf8;
 	}
 
-	constexpr uint32_t MAX_THREADS = 64;
-	jmp_buf _error_jump[MAX_THREADS];	// max number of threads. Set by omp_set_num_threads in data_compiler.cpp
-	char _error_message[2048];
-	const char *_error_where;
+	/// Thrown by parse_error() and caught by sjson::parse(). The error travels with the exception
+	/// instead of through globals, so any number of threads can parse at the same time.
+	struct ParseException
+	{
+		char message[1024];
+		const char *where;
+	};
 
 	void handle_parse_error(int line, const char *message, const char *where, ...)
 	{
+		ParseException e;
 		va_list args;
 		va_start(args, where);
 
-		vsnprintf(_error_message, sizeof(_error_message), message, args);
-		_error_where = where;
+		vsnprintf(e.message, sizeof(e.message), message, args);
+		e.where = where;
 		va_end(args);
 
-		longjmp(_error_jump[omp_get_thread_num()], 1);
+		throw e;
+	}
+
+#ifdef SJSON_SIMD
+	#ifdef __AVX2__
+		typedef __m256i Vector;
+		const unsigned VECTOR_SIZE = 32;
+		inline Vector load(const char *p) {return _mm256_loadu_si256((const __m256i *)p);}
+		inline Vector splat(char c) {return _mm256_set1_epi8(c);}
+		inline Vector equal(Vector a, Vector b) {return _mm256_cmpeq_epi8(a, b);}
+		inline Vector either(Vector a, Vector b) {return _mm256_or_si256(a, b);}
+		inline unsigned mask(Vector v) {return unsigned(_mm256_movemask_epi8(v));}
+		const unsigned ALL_BITS = 0xffffffffu;
+	#else
+		typedef __m128i Vector;
+		const unsigned VECTOR_SIZE = 16;
+		inline Vector load(const char *p) {return _mm_loadu_si128((const __m128i *)p);}
+		inline Vector splat(char c) {return _mm_set1_epi8(c);}
+		inline Vector equal(Vector a, Vector b) {return _mm_cmpeq_epi8(a, b);}
+		inline Vector either(Vector a, Vector b) {return _mm_or_si128(a, b);}
+		inline unsigned mask(Vector v) {return unsigned(_mm_movemask_epi8(v));}
+		const unsigned ALL_BITS = 0xffffu;
+	#endif
+
+	/// Index of the lowest set bit of @p m, which is not 0.
+	inline unsigned first_bit(unsigned m)
+	{
+	#ifdef _MSC_VER
+		unsigned long i;
+		_BitScanForward(&i, m);
+		return unsigned(i);
+	#else
+		return unsigned(__builtin_ctz(m));
+	#endif
+	}
+
+	/// Index of the highest set bit of @p m, which is not 0.
+	inline unsigned last_bit(unsigned m)
+	{
+	#ifdef _MSC_VER
+		unsigned long i;
+		_BitScanReverse(&i, m);
+		return unsigned(i);
+	#else
+		return 31u - unsigned(__builtin_clz(m));
+	#endif
+	}
+
+	inline unsigned count_bits(unsigned m)
+	{
+	#ifdef _MSC_VER
+		// __popcnt needs a CPU with POPCNT
+		m = m - ((m >> 1) & 0x55555555u);
+		m = (m & 0x33333333u) + ((m >> 2) & 0x33333333u);
+		return (((m + (m >> 4)) & 0x0f0f0f0fu) * 0x01010101u) >> 24;
+	#else
+		return unsigned(__builtin_popcount(m));
+	#endif
+	}
+#endif
+
+	/// The scanners return the first position in [p, end) with a character they look for, or end.
+	/// Only whole vectors that are inside the range are loaded, the rest is checked one byte at a time.
+
+	inline const char *find_char(const char *p, const char *end, char c)
+	{
+	#ifdef SJSON_SIMD
+		const Vector vc = splat(c);
+		for (; end - p >= ptrdiff_t(VECTOR_SIZE); p += VECTOR_SIZE) {
+			const unsigned m = mask(equal(load(p), vc));
+			if (m)
+				return p + first_bit(m);
+		}
+	#endif
+		while (p < end && *p != c)
+			++p;
+		return p;
+	}
+
+	/// Finds the end of the plain part of a string: the closing quote or an escape sequence.
+	inline const char *find_quote_or_escape(const char *p, const char *end)
+	{
+	#ifdef SJSON_SIMD
+		const Vector quote = splat('"');
+		const Vector escape = splat('\\');
+		for (; end - p >= ptrdiff_t(VECTOR_SIZE); p += VECTOR_SIZE) {
+			const Vector v = load(p);
+			const unsigned m = mask(either(equal(v, quote), equal(v, escape)));
+			if (m)
+				return p + first_bit(m);
+		}
+	#endif
+		while (p < end && *p != '"' && *p != '\\')
+			++p;
+		return p;
+	}
+
+	/// Finds the end of an unquoted key.
+	inline const char *find_identifier_end(const char *p, const char *end)
+	{
+	#ifdef SJSON_SIMD
+		const Vector space = splat(' ');
+		const Vector tab = splat('\t');
+		const Vector newline = splat('\n');
+		const Vector equals = splat('=');
+		const Vector colon = splat(':');
+		for (; end - p >= ptrdiff_t(VECTOR_SIZE); p += VECTOR_SIZE) {
+			const Vector v = load(p);
+			const unsigned m = mask(either(either(either(equal(v, space), equal(v, tab)), either(equal(v, newline), equal(v, equals))), equal(v, colon)));
+			if (m)
+				return p + first_bit(m);
+		}
+	#endif
+		while (p < end && *p != ' ' && *p != '\t' && *p != '\n' && *p != '=' && *p != ':')
+			++p;
+		return p;
+	}
+
+	inline bool is_blank(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',';
+	}
+
+	/// Skips whitespace and commas, which are optional separators.
+	inline const char *skip_blanks(const char *p, const char *end)
+	{
+		// Most values are preceded by a single space or none at all
+		if (p < end && !is_blank(*p))
+			return p;
+	#ifdef SJSON_SIMD
+		const Vector space = splat(' ');
+		const Vector tab = splat('\t');
+		const Vector newline = splat('\n');
+		const Vector carriage_return = splat('\r');
+		const Vector comma = splat(',');
+		for (; end - p >= ptrdiff_t(VECTOR_SIZE); p += VECTOR_SIZE) {
+			const Vector v = load(p);
+			const unsigned m = mask(either(either(either(equal(v, space), equal(v, tab)), either(equal(v, newline), equal(v, carriage_return))), equal(v, comma))) ^ ALL_BITS;
+			if (m)
+				return p + first_bit(m);
+		}
+	#endif
+		while (p < end && is_blank(*p))
+			++p;
+		return p;
 	}
 
 	struct Line {int number; const char *start; int length;};
@@ -66,6 +223,16 @@ namespace {
 		l.number = 1;
 		l.start = s;
 		l.length = 0;
+	#ifdef SJSON_SIMD
+		const Vector newline = splat('\n');
+		for (; p - s >= ptrdiff_t(VECTOR_SIZE); s += VECTOR_SIZE) {
+			const unsigned m = mask(equal(load(s), newline));
+			if (m) {
+				l.number += count_bits(m);
+				l.start = s + last_bit(m) + 1;
+			}
+		}
+	#endif
 		while (s < p) {
 			if (*s == '\n') {++l.number; l.start = s+1;}
 			++s;
@@ -90,21 +257,35 @@ namespace common
 	void skip_whitespace_no_error(const char *&start, const char *end);
 	void consume(const char *&start, const char *end, char c);
 	void skip_bom(const char *&start, const char *end);
+	void parse_string(const char *&start, const char *end, std::vector<char> &string);
 	void parse_string(const char *&start, const char *end, Value &string);
+	void parse_identifier(const char *&start, const char *end, std::vector<char> &string);
 	void parse_identifier(const char *&start, const char *end, Value &string);
 	void parse_number(const char *&start, const char *end, Value &number);
 	void parse_true(const char *&start, const char *end, Value &number);
 	void parse_false(const char *&start, const char *end, Value &number);
 	void parse_null(const char *&start, const char *end, Value &number);
+	void parse_data(const char *&start, const char *end, std::vector<char> &data);
 	void parse_data(const char *&start, const char *end, Value &data);
 } // namespace common
 
 namespace parse
 {
-	void parse_value(const char *&start, const char *end, Value &value);
-	void parse_object(const char *&start, const char *end, Value &object);
-	void parse_root_object(const char *&start, const char *end, Value &object);
-	void parse_array(const char *&start, const char *end, Value &array);
+	/// State of a parse into an arena. The values of an array or object are collected on the
+	/// stacks until it is complete and then moved into the arena as a single block.
+	struct Builder
+	{
+		ConfigArena *arena;
+		bool in_place;	///< Strings are terminated in the source and referred to instead of copied
+		std::vector<char> string;
+		std::vector<Value> values;
+		std::vector<const char *> keys;
+	};
+
+	void parse_value(const char *&start, const char *end, Builder &b);
+	void parse_object(const char *&start, const char *end, Builder &b);
+	void parse_root_object(const char *&start, const char *end, Builder &b);
+	void parse_array(const char *&start, const char *end, Builder &b);
 
 } // namespace parse
 
@@ -133,44 +314,70 @@ namespace {
 
 namespace sjson
 {
-	const char *generate_error_message(const char *start, const char *end)
+	const char *generate_error_message(const char *start, const char *end, const ParseException &e, ParseError &error)
 	{
-		static char buffer[2048] = {0};
-
-		Line line = ::line(start, end, _error_where);
+		Line line = ::line(start, end, e.where);
 		char text[81] = {0};
 		int to_copy = line.length;
 		if (to_copy > 80)
 			to_copy = 80;
 		memcpy(text, line.start, to_copy);
 
-		sprintf(buffer, "Parse error '%s' at line %i:\n\n%s", _error_message, line.number, text);
-		return buffer;
+		snprintf(error.message, sizeof(error.message), "Parse error '%s' at line %i:\n\n%s", e.message, line.number, text);
+		return error.message;
 	}
 
-	const char *parse(const Buffer b, DynamicConfigValue &value, bool error)
-	{
-		if (MAX_THREADS < omp_get_thread_num())
-			return "MAX_THREADS threads is lower than the current thread number";
-
-		if (setjmp(_error_jump[omp_get_thread_num()])) {
-			if (error) {
-				return generate_error_message(b.p, b.p + b.len);
-			} else {
-				return "Error!";
+	namespace {
+		const char *parse_into(const Buffer b, DynamicConfigValue &value, ParseError &error, ConfigArena *arena, bool in_place)
+		{
+			const char *result = nullptr;
+			arena->add_ref();
+			try {
+				parse::Builder builder;
+				builder.arena = arena;
+				builder.in_place = in_place;
+
+				const char *start = b.p;
+				const char *end = b.p + b.len;
+
+				common::skip_bom(start, end);
+				parse::parse_root_object(start, end, builder);
+				value.adopt(std::move(builder.values.back()));
+			} catch (const ParseException &e) {
+				result = generate_error_message(b.p, b.p + b.len, e, error);
 			}
-			
+			arena->release();
+			return result;
 		}
+	}
 
+	const char *parse(const Buffer b, DynamicConfigValue &value, ParseError &error)
+	{
 		if (b.len == 0)
 			return nullptr;
 
-		const char *start = b.p;
-		const char *end = b.p + b.len;
+		return parse_into(b, value, error, ConfigArena::create(b.len), false);
+	}
 
-		common::skip_bom(start, end);
-		parse::parse_root_object(start, end, value);
-		return nullptr;
+	const char *parse_in_place(Buffer b, DynamicConfigValue &value, ParseError &error, ConfigArena &arena)
+	{
+		if (b.len == 0) {
+			// Nothing refers to the arena
+			arena.add_ref();
+			arena.release();
+			return nullptr;
+		}
+
+		return parse_into(b, value, error, &arena, true);
+	}
+
+	const char *parse(const Buffer b, DynamicConfigValue &value, bool error)
+	{
+		static thread_local ParseError thread_error;
+		const char *message = parse(b, value, thread_error);
+		if (message && !error)
+			return "Error!";
+		return message;
 	}
 
 #ifdef CAN_COMPILE
@@ -180,18 +387,17 @@ namespace sjson
 	/// The first 29 bits of the return value is set as the tag (see DynamicConfigValue::set_tag()/tag()).
 	const char *parse(const Buffer b, DynamicConfigValue &value, TagDynamicConfigValueFunction tag_callback, void *user_data)
 	{
-		if (MAX_THREADS < omp_get_thread_num())
-			return "MAX_THREADS threads is lower than the current thread number";
-
-		if (setjmp(_error_jump[omp_get_thread_num()]))
-			return generate_error_message(b.p, b.p+b.len);
-
 		if (b.len == 0)
 			return nullptr;
 
-		parse_tagged::ParseData d = {b.p, b.p + b.len, b.p, tag_callback, user_data};
-		common::skip_bom(d.start, d.end);
-		parse_tagged::parse_root_object(d, value);
+		static thread_local ParseError error;
+		try {
+			parse_tagged::ParseData d = {b.p, b.p + b.len, b.p, tag_callback, user_data};
+			common::skip_bom(d.start, d.end);
+			parse_tagged::parse_root_object(d, value);
+		} catch (const ParseException &e) {
+			return generate_error_message(b.p, b.p + b.len, e, error);
+		}
 		return nullptr;
 	}
 
@@ -266,7 +472,7 @@ namespace sjson
 		if (es.error)
 			return es.error;
 
-		static char buffer[2048] = {0};
+		static thread_local char buffer[2048] = {0};
 		sjson::SourceLocation loc = sjson::location(node, es.source);
 		int o = snprintf(buffer, 2048, "Failure while parsing `%s`: \n%s(%d:%d): ", es.file, es.file, loc.line, loc.column);
 		vsnprintf(buffer+o, 2048-o, msg, args);
@@ -290,18 +496,14 @@ namespace sjson
 
 namespace common
 {
-	inline void set_object_key(const char *start, const char *end, Value& object, const char* key, Value& value)
+	void parse_string(const char *&start, const char *end, std::vector<char> &string)
 	{
-		parse_assert(!object.has(key), "Object already has key '%s'.", start, end, key);
-		object[key] = value;
-	}
-
-	void parse_string(const char *&start, const char *end, Value &value)
-	{
-		std::vector<char> string;
-
+		string.clear();
 		consume(start, end, '"');
 		while (true) {
+			const char *plain_end = find_quote_or_escape(start, end);
+			string.insert(string.end(), start, plain_end);
+			start = plain_end;
 			parse_assert(start < end, "Reached end of string while parsing", start, end);
 			char c = *start;
 			++start;
@@ -324,7 +526,7 @@ namespace common
 					hex[2] = start[2];
 					hex[3] = start[3];
 					start += 4;
-					int unicode;
+					int unicode = 0;
 					sscanf(hex, "%x", &unicode);
 					char utf8[5] = {0};
 					utf8_encode(unicode, utf8);
@@ -337,18 +539,28 @@ namespace common
 			}
 		}
 		string.push_back(0);
+	}
 
+	void parse_string(const char *&start, const char *end, Value &value)
+	{
+		std::vector<char> string;
+		parse_string(start, end, string);
 		value.set_string(string.data());
 	}
 
-	void parse_data(const char *&start, const char *end, Value &value) {
+	void parse_data(const char *&start, const char *end, std::vector<char> &string) {
 		consume(start, end, '"');
 		consume(start, end, '"');
 		consume(start, end, '"');
 
-		std::vector<char> string;
+		string.clear();
 
+		// A quote can't start the terminator in the last two bytes
+		const char *last = end - start > 2 ? end - 2 : start;
 		while (true) {
+			const char *quote = find_char(start, last, '"');
+			string.insert(string.end(), start, quote);
+			start = quote;
 			parse_assert(start+2 < end, "Reached end of data while parsing", start, end);
 
 			if (start[0]=='"' && start[1]=='"' && start[2]=='"' && !(start+3<end && start[3] == '"')) {
@@ -361,28 +573,32 @@ namespace common
 			++start;
 		}
 		string.push_back(0);
+	}
+
+	void parse_data(const char *&start, const char *end, Value &value) {
+		std::vector<char> string;
+		parse_data(start, end, string);
 		value.set_string(string.data());
 	}
 
-	void parse_identifier(const char *&start, const char *end, Value &value)
+	void parse_identifier(const char *&start, const char *end, std::vector<char> &string)
 	{
 		if (*start == '"') {
-			parse_string(start, end, value);
+			parse_string(start, end, string);
 			return;
 		}
 
-		std::vector<char> string;
-
-		while (true) {
-			parse_assert(start < end, "Reached end of string while parsing", start, end);
-			char c = *start;
-			if (c == ' ' || c == '\t' || c == '\n' || c == '=' || c == ':')
-				break;
-			++start;
-			string.push_back(c);
-		}
+		const char *identifier_end = find_identifier_end(start, end);
+		string.assign(start, identifier_end);
+		start = identifier_end;
+		parse_assert(start < end, "Reached end of string while parsing", start, end);
 		string.push_back(0);
+	}
 
+	void parse_identifier(const char *&start, const char *end, Value &value)
+	{
+		std::vector<char> string;
+		parse_identifier(start, end, string);
 		value.set_string(string.data());
 	}
 
@@ -503,12 +719,16 @@ namespace common
 	void skip_comment(const char *&start, const char *end)
 	{
 		if (start[1] == '/') {
-			while (start+1 < end && *start != '\n')
-				++start;
+			start = find_char(start, end - 1, '\n');
 			++start;
 		} else if (start[1] == '*') {
-			while (start+2 < end && (start[0] != '*' || start[1] != '/'))
+			const char *last = end - start > 2 ? end - 2 : start;
+			while (true) {
+				start = find_char(start, last, '*');
+				if (start == last || start[1] == '/')
+					break;
 				++start;
+			}
 			start += 2;
 		} else
 			parse_error("Bad comment", start, end);
@@ -516,12 +736,10 @@ namespace common
 
 	void skip_whitespace(const char *&start, const char *end)
 	{
-		while (start < end) {
-			const char start_char = *start;
-			if (start_char == '/')
+		while (true) {
+			start = skip_blanks(start, end);
+			if (start < end && *start == '/')
 				skip_comment(start, end);
-			else if (start_char == ' ' || start_char == '\t' || start_char == '\n' || start_char == '\r' || start_char == ',')
-				++start;
 			else
 				break;
 		}
@@ -529,12 +747,10 @@ namespace common
 
 	void skip_whitespace_no_error(const char *&start, const char *end)
 	{
-		while (start < end) {
-			const char start_char = *start;
-			if (start_char == '/')
+		while (true) {
+			start = skip_blanks(start, end);
+			if (start < end && *start == '/')
 				skip_comment(start, end);
-			else if (start_char == ' ' || start_char == '\t' || start_char == '\n' || start_char == '\r' || start_char == ',')
-				++start;
 			else
 				break;
 		}
@@ -544,112 +760,166 @@ namespace common
 namespace parse
 {
 	using namespace common;
-	void parse_value(const char *&start, const char *end, Value &value)
+
+	inline void push_string(Builder &b)
+	{
+		b.values.push_back(Value::frozen_string(*b.arena, b.string.data(), unsigned(b.string.size() - 1)));
+	}
+
+	/// Terminates a string without escape sequences in the source and refers to it. Returns false
+	/// without consuming anything for strings that have to be copied, or are malformed.
+	bool push_string_in_place(const char *&start, const char *end, Builder &b, bool data)
+	{
+		const char *s = start + (data ? 3 : 1);
+		const char *p = s;
+		if (data) {
+			// Same end condition as parse_data()
+			const char *last = end - p > 2 ? end - 2 : p;
+			while (true) {
+				p = find_char(p, last, '"');
+				if (p == last || (p[1]=='"' && p[2]=='"' && !(p+3<end && p[3] == '"')))
+					break;
+				++p;
+			}
+			if (p+2 >= end)
+				return false;
+		} else {
+			p = find_quote_or_escape(p, end);
+			if (p >= end || *p != '"')
+				return false;
+		}
+		b.values.push_back(Value::frozen_string_ref(*b.arena, s, unsigned(p - s)));
+		*const_cast<char *>(p) = 0;
+		start = p + (data ? 3 : 1);
+		return true;
+	}
+
+	inline void push_key(const char *&start, const char *end, Builder &b)
+	{
+		parse_identifier(start, end, b.string);
+		b.keys.push_back(b.arena->intern(b.string.data(), unsigned(b.string.size() - 1)));
+	}
+
+	/// Replaces the keys and values from the given stack positions with the object they form.
+	void end_object(const char *start, const char *end, Builder &b, size_t first_key, size_t first_value)
+	{
+		const unsigned size = unsigned(b.keys.size() - first_key);
+		const char *duplicate_key;
+		Value object = Value::frozen_object(*b.arena, b.keys.data() + first_key, b.values.data() + first_value, size, &duplicate_key);
+		parse_assert(duplicate_key == nullptr, "Object already has key '%s'.", start, end, duplicate_key);
+		b.keys.resize(first_key);
+		b.values.resize(first_value);
+		b.values.push_back(std::move(object));
+	}
+
+	void parse_value(const char *&start, const char *end, Builder &b)
 	{
 		skip_whitespace(start, end);
 
 		char c = *start;
 		if (c == '{')
-			parse_object(start, end, value);
+			parse_object(start, end, b);
 		else if (c == '[')
-			parse_array(start, end, value);
+			parse_array(start, end, b);
 		else if (c == '"') {
-			if (start+2 < end && (start[1] == '"' && start[2] == '"'))
-				parse_data(start, end, value);
+			const bool data = start+2 < end && (start[1] == '"' && start[2] == '"');
+			if (b.in_place && push_string_in_place(start, end, b, data))
+				return;
+			if (data)
+				parse_data(start, end, b.string);
 			else
-				parse_string(start, end, value);
-		} else if (c == '-' || (c >= '0' && c <= '9'))
-			parse_number(start, end, value);
-		else if (c == 't')
-			parse_true(start, end, value);
-		else if (c == 'f')
-			parse_false(start, end, value);
-		else if (c == 'n')
-			parse_null(start, end, value);
-		else
-			parse_error("Unexpected character", start, end);
+				parse_string(start, end, b.string);
+			push_string(b);
+		} else {
+			Value value;
+			if (c == '-' || (c >= '0' && c <= '9'))
+				parse_number(start, end, value);
+			else if (c == 't')
+				parse_true(start, end, value);
+			else if (c == 'f')
+				parse_false(start, end, value);
+			else if (c == 'n')
+				parse_null(start, end, value);
+			else
+				parse_error("Unexpected character", start, end);
+			b.values.push_back(std::move(value));
+		}
 	}
 
-	void parse_object(const char *&start, const char *end, Value &object)
+	void parse_object(const char *&start, const char *end, Builder &b)
 	{
-		object.set_empty_object();
+		const size_t first_key = b.keys.size();
+		const size_t first_value = b.values.size();
 		consume(start, end, '{');
 		skip_whitespace(start, end);
 		if (*start == '}') {
 			consume(start, end, '}');
+			end_object(start, end, b, first_key, first_value);
 			return;
 		}
 
 		while (true) {
-			Value key;
-			Value value;
-			parse_identifier(start, end, key);
+			push_key(start, end, b);
 			skip_whitespace(start, end);
 			if (*start == ':')
 				consume(start, end, ':');
 			else
 				consume(start, end, '=');
 			skip_whitespace(start, end);
-			parse_value(start, end, value);
-			set_object_key(start, end, object, key.to_string_unsafe(), value);
+			parse_value(start, end, b);
 			skip_whitespace(start, end);
 			if (*start == '}')
 				break;
 		}
 		consume(start, end, '}');
+		end_object(start, end, b, first_key, first_value);
 	}
 
-	void parse_root_object(const char *&start, const char *end, Value &object)
+	void parse_root_object(const char *&start, const char *end, Builder &b)
 	{
 		skip_whitespace_no_error(start, end);
 		if (*start  == '{') {
-			parse_object(start, end, object);
+			parse_object(start, end, b);
 			return;
 		}
 
-		if (start == end)
-			return;
-
-		object.set_empty_object();
-		while (true) {
-			Value key;
-			Value value;
-			parse_identifier(start, end, key);
+		const size_t first_key = b.keys.size();
+		const size_t first_value = b.values.size();
+		while (start != end) {
+			push_key(start, end, b);
 			skip_whitespace(start, end);
 			if (*start == ':')
 				consume(start, end, ':');
 			else
 				consume(start, end, '=');
 			skip_whitespace(start, end);
-			parse_value(start, end, value);
-			set_object_key(start, end, object, key.to_string_unsafe(), value);
+			parse_value(start, end, b);
 			skip_whitespace_no_error(start, end);
-			if (start == end)
-				return;
 		}
+		end_object(start, end, b, first_key, first_value);
 	}
 
-	void parse_array(const char *&start, const char *end, Value &array)
+	void parse_array(const char *&start, const char *end, Builder &b)
 	{
-		array.set_empty_array();
+		const size_t first_value = b.values.size();
 		consume(start, end, '[');
 		skip_whitespace(start, end);
 		if (*start == ']') {
 			consume(start, end, ']');
-			return;
+		} else {
+			while (true) {
+				parse_value(start, end, b);
+				skip_whitespace(start, end);
+				if (*start == ']')
+					break;
+			}
+			consume(start, end, ']');
 		}
 
-		while (true) {
-			Value data;
-			parse_value(start, end, data);
-			skip_whitespace(start, end);
-			array.push() = data;
-			skip_whitespace(start, end);
-			if (*start == ']')
-				break;
-			skip_whitespace(start, end);
-		}
-		consume(start, end, ']');
+		const unsigned size = unsigned(b.values.size() - first_value);
+		Value array = Value::frozen_array(*b.arena, b.values.data() + first_value, size);
+		b.values.resize(first_value);
+		b.values.push_back(std::move(array));
 	}
 } // namespace parse
 
@@ -657,6 +927,13 @@ namespace parse
 namespace parse_tagged
 {
 	using namespace common;
+
+	inline void set_object_key(const char *start, const char *end, Value& object, const char* key, Value& value)
+	{
+		parse_assert(!object.has(key), "Object already has key '%s'.", start, end, key);
+		object[key] = value;
+	}
+
 	void parse_array(ParseData &d, Value &array)
 	{
 		array.set_empty_array();
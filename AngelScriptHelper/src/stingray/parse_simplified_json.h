@@ -17,6 +17,7 @@ namespace stingray {
 	};
 
 class DynamicConfigValue;
+class ConfigArena;
 
 /// Parses simplified JSON data.
 namespace sjson
@@ -42,9 +43,25 @@ namespace sjson
 	/// with regular JSON.
 	///
 	/// If there is an error with parsing, an error message will be returned. Otherwise the function will
-	/// return nullptr.
+	/// return nullptr. The message is valid until the next parse on the same thread.
+	///
+	/// The parser has no shared state, so it can be called from any number of threads at the same time.
 	const char *parse(Buffer b, DynamicConfigValue &value, bool error = true);
 
+	/// Receives the message of a failed parse.
+	struct ParseError
+	{
+		char message[2048];
+	};
+
+	/// Same as above, with the error message written to @p error. Returns nullptr or error.message.
+	const char *parse(Buffer b, DynamicConfigValue &value, ParseError &error);
+
+	/// Parses into @p arena without copying the strings: they are null terminated in @p b itself and
+	/// the values point into it. @p b has to be writable and live as long as the arena, which can
+	/// own it through ConfigArena::add_finalizer(). The arena is destroyed if nothing refers to it.
+	const char *parse_in_place(Buffer b, DynamicConfigValue &value, ParseError &error, ConfigArena &arena);
+
 	#ifdef CAN_COMPILE
 		/// Used to track errors during parsing.
 		struct ErrorState
@@ -24,12 +24,12 @@ string IncludeFile(string includeFile, string fromFile){
     if(includeFile.substr(0, 5) == "core/"){
         includeFile = CoreFolder + includeFile;
     }
+    //return the resolved path, Ash reads and caches the file itself
     file f;
     print("Including: " + includeFile);
     if(f.open(dir + includeFile, "r") >= 0 ){
-        string s = f.readString(f.getSize());
         f.close();
-        return s;
+        return dir + includeFile;
     }
 
     return "error";
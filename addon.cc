@@ -0,0 +1,377 @@
+#include <node_api.h>
+#include <angelscript.h>
+#include <AngelScriptExporter.h>
+#include <SymbolIndex.h>
+#include "AngelScript/scriptbuilder/scriptbuilder.h"
+#include "IncludeHandler.h"
+
+#include <rapidjson/document.h>
+#include <rapidjson/ostreamwrapper.h>
+#include <rapidjson/writer.h>
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+using namespace AngelScript;
+
+/*
+In-process version of Ash.exe for the extension.
+	compile(source, interfacePath[, options]) -> { Success, Errors, Warnings, Infos }
+	reflect(source, interfacePath[, outputPath[, sharded[, options]]]) -> { Success, Errors, Warnings, Infos, Module }
+	complete(interfacePath, prefix[, namespace[, max]]) -> [ { Name, Namespace, Kind, Declaration } ]
+		without a namespace the top level namespaces starting with prefix follow, with Kind "Namespace"
+options is { Defines: string[], IncludeHandler: string }, the same as -d and -ih of Ash.exe.
+Engines are kept alive per interface file so the interface is only imported once, and are
+rebuilt when the file changes on disk. Include handlers are kept the same way per script.
+*/
+
+struct Message {
+	uint32_t type;
+	std::string section;
+	uint32_t line;
+	uint32_t column;
+	std::string message;
+};
+
+//An imported interface, together with the state of the file it was imported from
+struct CachedEngine {
+	asIScriptEngine* engine = nullptr;
+	time_t modified = 0;
+	long long size = -1;
+	//built on the first completion request
+	bool hasSymbols = false;
+	AngelScriptExporter::SymbolIndex symbols;
+};
+
+struct CachedIncludeHandler {
+	IncludeHandler handler;
+	time_t modified = 0;
+};
+
+static std::vector<Message> g_Messages;
+static std::map<std::string, CachedEngine> g_Engines;
+static std::map<std::string, CachedIncludeHandler> g_IncludeHandlers;
+
+static void MessageCallback(const asSMessageInfo* msg, void* param) {
+	Message m;
+	m.line = msg->row;
+	m.column = msg->col;
+	m.type = msg->type;
+	m.section = msg->section;
+	m.message = msg->message;
+	g_Messages.push_back(m);
+}
+
+//A missing file gets a size of -1, so it is rebuilt once it appears
+static void GetFileState(const std::string& file, time_t& modified, long long& size) {
+	struct stat s;
+	if (file.empty() || stat(file.c_str(), &s) != 0) {
+		modified = 0;
+		size = -1;
+		return;
+	}
+	modified = s.st_mtime;
+	size = s.st_size;
+}
+
+static CachedEngine& GetCachedEngine(const std::string& interfaceFile) {
+	time_t modified;
+	long long size;
+	GetFileState(interfaceFile, modified, size);
+	CachedEngine& cached = g_Engines[interfaceFile];
+	if (cached.engine && cached.modified == modified && cached.size == size) {
+		return cached;
+	}
+	if (cached.engine) {
+		cached.engine->ShutDownAndRelease();
+	}
+	cached = CachedEngine();
+	asIScriptEngine* engine = asCreateScriptEngine();
+	engine->SetMessageCallback(asFUNCTION(MessageCallback), 0, asCALL_CDECL);
+	engine->SetEngineProperty(asEP_INIT_GLOBAL_VARS_AFTER_BUILD, false);
+	if (!interfaceFile.empty() && AngelScriptExporter::ImportEngineFromBinary(interfaceFile.c_str(), engine) == AngelScriptExporter::BINARY_IMPORT_NOT_BINARY) {
+		AngelScriptExporter::ImportEngineFromJson(interfaceFile.c_str(), engine);
+	}
+	cached.engine = engine;
+	cached.modified = modified;
+	cached.size = size;
+	return cached;
+}
+
+static asIScriptEngine* GetEngine(const std::string& interfaceFile) {
+	return GetCachedEngine(interfaceFile).engine;
+}
+
+//Keeps the resolved includes between builds, the script is set up again when it changes
+static IncludeHandler* GetIncludeHandler(const std::string& file) {
+	if (file.empty()) {
+		return nullptr;
+	}
+	time_t modified = 0;
+	GetModifiedTime(file, modified);
+	auto it = g_IncludeHandlers.find(file);
+	if (it != g_IncludeHandlers.end()) {
+		if (it->second.modified == modified) {
+			return &it->second.handler;
+		}
+		ReleaseIncludeHandler(it->second.handler);
+	} else {
+		it = g_IncludeHandlers.insert(std::make_pair(file, CachedIncludeHandler())).first;
+	}
+	SetupIncludeHandler(file, it->second.handler);
+	it->second.modified = modified;
+	return &it->second.handler;
+}
+
+static void ReleaseEngines(void*) {
+	for (auto& e : g_Engines) {
+		e.second.engine->ShutDownAndRelease();
+	}
+	g_Engines.clear();
+	for (auto& ih : g_IncludeHandlers) {
+		ReleaseIncludeHandler(ih.second.handler);
+	}
+	g_IncludeHandlers.clear();
+}
+
+static bool GetStringArg(napi_env env, napi_value value, std::string& out) {
+	size_t length = 0;
+	if (napi_get_value_string_utf8(env, value, nullptr, 0, &length) != napi_ok) {
+		return false;
+	}
+	out.resize(length);
+	napi_get_value_string_utf8(env, value, &out[0], length + 1, &length);
+	return true;
+}
+
+//Reads { Defines: string[], IncludeHandler: string }, missing properties are left empty
+static void GetOptionsArg(napi_env env, napi_value value, std::vector<std::string>& defines, std::string& includeHandler) {
+	napi_valuetype type;
+	if (napi_typeof(env, value, &type) != napi_ok || type != napi_object) {
+		return;
+	}
+	bool has = false;
+	napi_value property;
+	if (napi_has_named_property(env, value, "Defines", &has) == napi_ok && has) {
+		napi_get_named_property(env, value, "Defines", &property);
+		uint32_t length = 0;
+		if (napi_get_array_length(env, property, &length) == napi_ok) {
+			for (uint32_t i = 0; i < length; ++i) {
+				napi_value element;
+				std::string define;
+				napi_get_element(env, property, i, &element);
+				if (GetStringArg(env, element, define) && !define.empty()) {
+					defines.push_back(define);
+				}
+			}
+		}
+	}
+	if (napi_has_named_property(env, value, "IncludeHandler", &has) == napi_ok && has) {
+		napi_get_named_property(env, value, "IncludeHandler", &property);
+		GetStringArg(env, property, includeHandler);
+	}
+}
+
+static napi_value ToJS(napi_env env, const rapidjson::Value& v) {
+	napi_value result;
+	switch (v.GetType()) {
+	case rapidjson::kNullType:
+		napi_get_null(env, &result);
+		break;
+	case rapidjson::kFalseType:
+	case rapidjson::kTrueType:
+		napi_get_boolean(env, v.GetBool(), &result);
+		break;
+	case rapidjson::kNumberType:
+		napi_create_double(env, v.GetDouble(), &result);
+		break;
+	case rapidjson::kStringType:
+		napi_create_string_utf8(env, v.GetString(), v.GetStringLength(), &result);
+		break;
+	case rapidjson::kArrayType: {
+		napi_create_array_with_length(env, v.Size(), &result);
+		uint32_t i = 0;
+		for (auto& e : v.GetArray()) {
+			napi_set_element(env, result, i++, ToJS(env, e));
+		}
+		break;
+	}
+	case rapidjson::kObjectType:
+		napi_create_object(env, &result);
+		for (auto& m : v.GetObject()) {
+			napi_set_named_property(env, result, m.name.GetString(), ToJS(env, m.value));
+		}
+		break;
+	}
+	return result;
+}
+
+static void SetMessages(napi_env env, napi_value result) {
+	napi_value errors, warnings, infos;
+	napi_create_array(env, &errors);
+	napi_create_array(env, &warnings);
+	napi_create_array(env, &infos);
+	uint32_t errorCount = 0, warningCount = 0, infoCount = 0;
+	for (auto& m : g_Messages) {
+		napi_value message, value;
+		napi_create_object(env, &message);
+		napi_create_uint32(env, m.line, &value);
+		napi_set_named_property(env, message, "Line", value);
+		napi_create_uint32(env, m.column, &value);
+		napi_set_named_property(env, message, "Column", value);
+		napi_create_string_utf8(env, m.message.c_str(), m.message.size(), &value);
+		napi_set_named_property(env, message, "Message", value);
+		napi_create_string_utf8(env, m.section.c_str(), m.section.size(), &value);
+		napi_set_named_property(env, message, "Section", value);
+		if (m.type == asMSGTYPE_ERROR) {
+			napi_set_element(env, errors, errorCount++, message);
+		} else if (m.type == asMSGTYPE_WARNING) {
+			napi_set_element(env, warnings, warningCount++, message);
+		} else if (m.type == asMSGTYPE_INFORMATION) {
+			napi_set_element(env, infos, infoCount++, message);
+		}
+	}
+	napi_set_named_property(env, result, "Errors", errors);
+	napi_set_named_property(env, result, "Warnings", warnings);
+	napi_set_named_property(env, result, "Infos", infos);
+}
+
+static napi_value CompileAndReflect(napi_env env, napi_callback_info info, bool reflect) {
+	size_t argc = 5;
+	napi_value argv[5];
+	napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+
+	std::string sourceFile, interfaceFile, outputFile, includeHandler;
+	std::vector<std::string> defines;
+	bool sharded = false;
+	if (argc < 2 || !GetStringArg(env, argv[0], sourceFile) || !GetStringArg(env, argv[1], interfaceFile)) {
+		napi_throw_type_error(env, nullptr, "Expected (source: string, interfacePath: string)");
+		return nullptr;
+	}
+	if (reflect && argc > 2) {
+		GetStringArg(env, argv[2], outputFile);
+	}
+	if (reflect && argc > 3) {
+		napi_get_value_bool(env, argv[3], &sharded);
+	}
+	size_t optionsArg = reflect ? 4 : 2;
+	if (argc > optionsArg) {
+		GetOptionsArg(env, argv[optionsArg], defines, includeHandler);
+	}
+
+	g_Messages.clear();
+	asIScriptEngine* engine = GetEngine(interfaceFile);
+	IncludeHandler* includer = GetIncludeHandler(includeHandler);
+	CScriptBuilder builder;
+	if (includer) {
+		includer->resolveFailed = false;
+		builder.SetIncludeCallback(CustomInclude, includer);
+	}
+	int r = builder.StartNewModule(engine, sourceFile.c_str());
+	for (auto& d : defines) {
+		builder.DefineWord(d.c_str());
+	}
+	r = builder.AddSectionFromFile(sourceFile.c_str());
+	r = builder.BuildModule();
+	asIScriptModule* module = builder.GetModule();
+
+	napi_value result, success;
+	napi_create_object(env, &result);
+	napi_get_boolean(env, r >= 0, &success);
+	napi_set_named_property(env, result, "Success", success);
+	SetMessages(env, result);
+
+	//only reflect the module if the compile succeeds
+	if (reflect && r >= 0) {
+		rapidjson::Document reflection;
+		AngelScriptExporter::ReflectModule(reflection, module, engine);
+		napi_set_named_property(env, result, "Module", ToJS(env, reflection));
+		if (!outputFile.empty() && sharded) {
+			AngelScriptExporter::ExportModuleAsShards(outputFile.c_str(), module, engine);
+		} else if (!outputFile.empty()) {
+			std::ofstream outFile(outputFile);
+			rapidjson::OStreamWrapper wrapper(outFile);
+			rapidjson::Writer<rapidjson::OStreamWrapper> writer(wrapper);
+			reflection.Accept(writer);
+		}
+	}
+	if (module) {
+		module->Discard();
+	}
+	return result;
+}
+
+static napi_value Compile(napi_env env, napi_callback_info info) {
+	return CompileAndReflect(env, info, false);
+}
+
+static napi_value Reflect(napi_env env, napi_callback_info info) {
+	return CompileAndReflect(env, info, true);
+}
+
+static napi_value Complete(napi_env env, napi_callback_info info) {
+	size_t argc = 4;
+	napi_value argv[4];
+	napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+
+	std::string interfaceFile, prefix, nameSpace;
+	if (argc < 2 || !GetStringArg(env, argv[0], interfaceFile) || !GetStringArg(env, argv[1], prefix)) {
+		napi_throw_type_error(env, nullptr, "Expected (interfacePath: string, prefix: string)");
+		return nullptr;
+	}
+	bool hasNamespace = argc > 2 && GetStringArg(env, argv[2], nameSpace);
+	uint32_t maxResults = 0;
+	if (argc > 3) {
+		napi_get_value_uint32(env, argv[3], &maxResults);
+	}
+
+	CachedEngine& cached = GetCachedEngine(interfaceFile);
+	if (!cached.hasSymbols) {
+		cached.symbols.AddEngine(cached.engine);
+		cached.hasSymbols = true;
+	}
+	std::vector<const AngelScriptExporter::Symbol*> results;
+	cached.symbols.Find(prefix.c_str(), results, AngelScriptExporter::SYMBOL_ALL, hasNamespace ? nameSpace.c_str() : nullptr, maxResults);
+
+	//namespaces are matched on their own name, symbols inside them don't have to start with the prefix
+	size_t symbolCount = results.size();
+	if (!hasNamespace) {
+		cached.symbols.FindNamespaces(prefix.c_str(), results, maxResults);
+	}
+
+	napi_value result;
+	napi_create_array_with_length(env, results.size(), &result);
+	for (uint32_t i = 0; i < results.size(); ++i) {
+		const AngelScriptExporter::Symbol* symbol = results[i];
+		napi_value entry, value;
+		napi_create_object(env, &entry);
+		napi_create_string_utf8(env, symbol->name.c_str(), symbol->name.size(), &value);
+		napi_set_named_property(env, entry, "Name", value);
+		napi_create_string_utf8(env, symbol->nameSpace.c_str(), symbol->nameSpace.size(), &value);
+		napi_set_named_property(env, entry, "Namespace", value);
+		napi_create_string_utf8(env, i < symbolCount ? AngelScriptExporter::GetSymbolKindName(symbol->kind) : "Namespace", NAPI_AUTO_LENGTH, &value);
+		napi_set_named_property(env, entry, "Kind", value);
+		napi_create_string_utf8(env, symbol->declaration.c_str(), symbol->declaration.size(), &value);
+		napi_set_named_property(env, entry, "Declaration", value);
+		napi_set_element(env, result, i, entry);
+	}
+	return result;
+}
+
+static napi_value Init(napi_env env, napi_value exports) {
+	napi_property_descriptor desc[] = {
+		{ "compile", nullptr, Compile, nullptr, nullptr, nullptr, napi_default, nullptr },
+		{ "reflect", nullptr, Reflect, nullptr, nullptr, nullptr, napi_default, nullptr },
+		{ "complete", nullptr, Complete, nullptr, nullptr, nullptr, napi_default, nullptr }
+	};
+	napi_define_properties(env, exports, sizeof(desc) / sizeof(desc[0]), desc);
+	napi_add_env_cleanup_hook(env, ReleaseEngines, nullptr);
+	//stdout belongs to the extension host
+	g_LogStream = stderr;
+	return exports;
+}
+
+NAPI_MODULE(NODE_GYP_MODULE_NAME, Init)
@@ -2,7 +2,34 @@
   "targets": [
     {
       "target_name": "addon",
-      "sources": [ "hello.cc" ]
+      "sources": [
+        "addon.cc",
+        "AngelScriptHelper/ash_lib_src/AngelScriptExporter.cpp",
+        "AngelScriptHelper/ash_lib_src/SymbolIndex.cpp",
+        "AngelScriptHelper/src/AngelScript/scriptbuilder/scriptbuilder.cpp",
+        "AngelScriptHelper/src/IncludeHandler.cpp",
+        "AngelScriptHelper/src/AngelScript/scriptarray/scriptarray.cpp",
+        "AngelScriptHelper/src/AngelScript/scriptpool/scriptpool.cpp",
+        "AngelScriptHelper/src/AngelScript/scriptstdstring/scriptstdstring.cpp",
+        "AngelScriptHelper/src/AngelScript/scriptstdstring/scriptstdstring_utils.cpp",
+        "AngelScriptHelper/src/AngelScript/scriptfile/scriptfile.cpp",
+        "AngelScriptHelper/src/AngelScript/scriptfile/scriptfilesystem.cpp",
+        "AngelScriptHelper/src/stingray/asif_dynamic_config.cpp",
+        "AngelScriptHelper/src/stingray/config_files.cpp",
+        "AngelScriptHelper/src/stingray/dynamic_config_value.cpp",
+        "AngelScriptHelper/src/stingray/parse_simplified_json.cpp"
+      ],
+      "include_dirs": [
+        "AngelScriptHelper/include",
+        "AngelScriptHelper/ash_lib_src",
+        "AngelScriptHelper/src",
+        "AngelScriptHelper/src/AngelScript/scriptarray"
+      ],
+      "defines": [ "AS_USE_NAMESPACE", "_CRT_SECURE_NO_WARNINGS", "NOMINMAX" ],
+      "libraries": [ "<(module_root_dir)/AngelScriptHelper/libs/angelscript64.lib" ],
+      "msvs_settings": {
+        "VCCLCompilerTool": { "ExceptionHandling": 1 }
+      }
     }
   ]
 }
\ No newline at end of file
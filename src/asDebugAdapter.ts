@@ -156,6 +156,8 @@ export class ASDebugSession extends LoggingDebugSession {
 			this._callstack = jsonMsg.CallStack;
 			this._global_vars = jsonMsg.GlobalVars;
 			this.sendEvent(new StoppedEvent('step', ASDebugSession.THREAD_ID));
+		}else if(jsonMsg.Type === 'Output'){
+			this.sendEvent(new OutputEvent(jsonMsg.Text, 'console'));
 		}
 	}
 
@@ -372,6 +374,7 @@ export class ASDebugSession extends LoggingDebugSession {
 class DebuggerConnection{
 	m_Socket:net.Socket;
 	m_Session:ASDebugSession;
+	m_Received:string = '';
 
 	constructor(ip:string, port:number, session: ASDebugSession){
 		this.m_Socket = new net.Socket();
@@ -380,8 +383,18 @@ class DebuggerConnection{
 		this.m_Socket.write('{\"Type\":\"OpenConnection\"}');
 		this.m_Socket.write('\n');
 		this.m_Session = session;
+		//messages are separated by new lines and may arrive split up or several at once
 		this.m_Socket.on('data', (data:string) => {
-			this.m_Session.onData(data);
+			this.m_Received += data.toString();
+			let end = this.m_Received.indexOf('\n');
+			while(end >= 0){
+				let msg = this.m_Received.substring(0, end);
+				this.m_Received = this.m_Received.substring(end + 1);
+				if(msg.length > 0){
+					this.m_Session.onData(msg);
+				}
+				end = this.m_Received.indexOf('\n');
+			}
 		});
 	}
 
@@ -9,10 +9,83 @@ import {ASDebugSession} from './asDebugAdapter';
 import * as Net from 'net';
 import { networkInterfaces } from 'os';
 let asTaskProvider: vscode.Disposable | undefined;
+
+//Parsed json files, only read again when they change on disk
+let jsonCache = new Map<string, {mtime: number, value: any}>();
+function readJSONCached(file: string): any {
+	var fs = require('fs');
+	let mtime = fs.statSync(file).mtimeMs;
+	let entry = jsonCache.get(file);
+	if(!entry || entry.mtime !== mtime){
+		entry = {mtime: mtime, value: JSON.parse(fs.readFileSync(file))};
+		jsonCache.set(file, entry);
+	}
+	return entry.value;
+}
+
+//Module reflection written by Ash with --shard: a symbol index plus one file per script section, shards are only parsed when something in them is needed
+class ModuleReflection {
+	public symbols: any[] = [];
+	private shardFiles: string[] = [];
+	private whole: any;
+
+	constructor(file: string, index: any) {
+		var path = require('path');
+		if(index.Sharded){
+			this.symbols = index.Symbols;
+			this.shardFiles = index.Shards.map(s => path.join(path.dirname(file), s.File));
+		}else{
+			//single file reflection from an older Ash
+			this.whole = index;
+			index.Functions.forEach(f => this.symbols.push({Name: f.Name, Namespace: f.Namespace, Kind: 'Function', Shard: -1, Declaration: f.Declaration}));
+			index.Types.forEach(t => this.symbols.push({Name: t.Name, Namespace: t.Namespace, Kind: 'Type', Shard: -1}));
+			index.TypeDefs.forEach(t => this.symbols.push({Name: t.Name, Namespace: t.Namespace, Kind: 'TypeDef', Shard: -1, Type: t.Type}));
+			index.Enums.forEach(e => this.symbols.push({Name: e.Name, Namespace: '', Kind: 'Enum', Shard: -1}));
+			index.GlobalVariables.forEach(v => this.symbols.push({Name: v.Name, Namespace: v.Namespace, Kind: 'Variable', Shard: -1, Type: v.Type}));
+		}
+	}
+
+	public shard(i: number): any {
+		return i < 0 ? this.whole : readJSONCached(this.shardFiles[i]);
+	}
+
+	public findType(name: string): any {
+		for(let s of this.symbols){
+			if(s.Kind === 'Type' && s.Name === name){
+				return this.shard(s.Shard).Types.find(t => t.Name === name);
+			}
+		}
+		return undefined;
+	}
+}
+
+let moduleReflections = new Map<string, {index: any, reflection: ModuleReflection}>();
+function loadModuleReflection(moduleCache: string, documentFile: string): ModuleReflection {
+	var path = require('path');
+	let file = moduleCache + path.parse(documentFile).name + '.json';
+	let index = readJSONCached(file);
+	let entry = moduleReflections.get(file);
+	if(!entry || entry.index !== index){
+		entry = {index: index, reflection: new ModuleReflection(file, index)};
+		moduleReflections.set(file, entry);
+	}
+	return entry.reflection;
+}
 // this method is called when your extension is activated
 // your extension is activated the very first time the command is executed
 export function activate(context: vscode.ExtensionContext) {
 
+	//in-process compiler, falls back to running Ash.exe if the addon hasn't been built
+	let nativeCompiler : any = undefined;
+	try{
+		nativeCompiler = require('../build/Release/addon.node');
+		if(!nativeCompiler.compile){
+			nativeCompiler = undefined;
+		}
+	}catch(e){
+		nativeCompiler = undefined;
+	}
+
 	let globalProvider = vscode.languages.registerCompletionItemProvider({scheme:'file', language:'angelscript'}, {
 
 		provideCompletionItems(document: vscode.TextDocument, position: vscode.Position, token: vscode.CancellationToken, context: vscode.CompletionContext) {
@@ -23,42 +96,67 @@ export function activate(context: vscode.ExtensionContext) {
 			if(interfaceFile === ''){
 				return null;
 			}
-			var fs = require('fs');
-			var interfaceObject;
-			var interfaceJSON = fs.readFileSync(interfaceFile);
-			interfaceObject = JSON.parse(interfaceJSON);
-
 			let namespaces = new Set();
-			interfaceObject.GlobalFunctions.forEach(func => {
-				if(func.Namespace === ''){
-					let comp = new vscode.CompletionItem(func.Name, vscode.CompletionItemKind.Function);
-					comp.detail = func.ReturnType + " " + func.Name + "(";
-					func.Params.forEach(param => {
-						comp.detail += param.Type + " " + param.Name + ", ";
-					});
-					comp.detail += ")";
-					comp.commitCharacters = ['('];
-					completions.push(comp);
-				}else{
-					namespaces.add(func.Namespace);
+			if(nativeCompiler && nativeCompiler.complete){
+				//prefix lookup in the symbol index of the interface instead of going through all of it
+				let wordRange = document.getWordRangeAtPosition(position);
+				let prefix = wordRange ? document.getText(new vscode.Range(wordRange.start, position)) : '';
+				for(let symbol of nativeCompiler.complete(interfaceFile, prefix)){
+					if(symbol.Kind === 'Namespace'){
+						namespaces.add(symbol.Name);
+					}else if(symbol.Kind === 'EnumValue' || symbol.Namespace !== ''){
+						continue;
+					}else if(symbol.Kind === 'Function'){
+						let comp = new vscode.CompletionItem(symbol.Name, vscode.CompletionItemKind.Function);
+						comp.detail = symbol.Declaration;
+						comp.commitCharacters = ['('];
+						completions.push(comp);
+					}else if(symbol.Kind === 'Type'){
+						let comp = new vscode.CompletionItem(symbol.Name, vscode.CompletionItemKind.Class);
+						comp.commitCharacters = ['('];
+						completions.push(comp);
+					}else if(symbol.Kind === 'Enum'){
+						let comp = new vscode.CompletionItem(symbol.Name, vscode.CompletionItemKind.Enum);
+						comp.commitCharacters = [':'];
+						completions.push(comp);
+					}
 				}
-			});
+			}else{
+				var fs = require('fs');
+				var interfaceObject;
+				interfaceObject = readJSONCached(interfaceFile);
+
+				interfaceObject.GlobalFunctions.forEach(func => {
+					if(func.Namespace === ''){
+						let comp = new vscode.CompletionItem(func.Name, vscode.CompletionItemKind.Function);
+						comp.detail = func.ReturnType + " " + func.Name + "(";
+						func.Params.forEach(param => {
+							comp.detail += param.Type + " " + param.Name + ", ";
+						});
+						comp.detail += ")";
+						comp.commitCharacters = ['('];
+						completions.push(comp);
+					}else{
+						namespaces.add(func.Namespace);
+					}
+				});
 
-			interfaceObject.GlobalTypes.forEach(type => {
-				if(type.Namespace === ''){
-					let comp = new vscode.CompletionItem(type.Name, vscode.CompletionItemKind.Class);
-					comp.commitCharacters = ['('];
-					completions.push(comp);
-				}else{
-					namespaces.add(type.Namespace);
-				}
-			});
+				interfaceObject.GlobalTypes.forEach(type => {
+					if(type.Namespace === ''){
+						let comp = new vscode.CompletionItem(type.Name, vscode.CompletionItemKind.Class);
+						comp.commitCharacters = ['('];
+						completions.push(comp);
+					}else{
+						namespaces.add(type.Namespace);
+					}
+				});
 
-			interfaceObject.GlobalEnums.forEach(e => {
-				let comp = new vscode.CompletionItem(e.Name, vscode.CompletionItemKind.Enum);
-				comp.commitCharacters = [':'];
-				completions.push(comp);
-			});
+				interfaceObject.GlobalEnums.forEach(e => {
+					let comp = new vscode.CompletionItem(e.Name, vscode.CompletionItemKind.Enum);
+					comp.commitCharacters = [':'];
+					completions.push(comp);
+				});
+			}
 
 			for (let space of namespaces){
 				let comp = new vscode.CompletionItem(space, vscode.CompletionItemKind.Interface);
@@ -68,50 +166,39 @@ export function activate(context: vscode.ExtensionContext) {
 
 			let moduleCache = settings['moduleCacheDir'];
 			if(moduleCache){
-				var path = require('path');
-				let cachedModuleFile = moduleCache + path.parse(document.fileName).name + '.json';
-				let moduleJSON = fs.readFileSync(cachedModuleFile);
-				let moduleObject = JSON.parse(moduleJSON);
-
-				moduleObject.Functions.forEach(func => {
-					let comp = new vscode.CompletionItem(func.Name, vscode.CompletionItemKind.Module);
-					comp.detail = func.ReturnType + " " + func.Name + "(";
-					func.Params.forEach(param => {
-						comp.detail += param.Type + " " + param.Name + ", ";
-					});
-					comp.detail += ")";
-					comp.commitCharacters = ['('];
-					completions.push(comp);
-				});
-	
-				moduleObject.Types.forEach(type => {
-					let comp = new vscode.CompletionItem(type.Name, vscode.CompletionItemKind.Struct);
-					comp.commitCharacters = ['(', ' '];
-					completions.push(comp);
-					//Push methods as well
-					for(let meth of type.Methods){
-						let mComp = new vscode.CompletionItem(meth.Name, vscode.CompletionItemKind.Method);
-						mComp.detail = meth.ReturnType + " " + meth.Name + "(";
-						meth.Params.forEach(param => {
-							mComp.detail += param.Type + " " + param.Name + ", ";
-						});
-						mComp.detail += ")";
-						mComp.commitCharacters = ['(', ' '];
-						completions.push(mComp);
+				let reflection = loadModuleReflection(moduleCache, document.fileName);
+				for(let symbol of reflection.symbols){
+					if(symbol.Kind === 'Function'){
+						let comp = new vscode.CompletionItem(symbol.Name, vscode.CompletionItemKind.Module);
+						comp.detail = symbol.Declaration;
+						comp.commitCharacters = ['('];
+						completions.push(comp);
+					}else if(symbol.Kind === 'Type'){
+						let comp = new vscode.CompletionItem(symbol.Name, vscode.CompletionItemKind.Struct);
+						comp.commitCharacters = ['(', ' '];
+						completions.push(comp);
+						//Push methods as well
+						let type = reflection.shard(symbol.Shard).Types.find(t => t.Name === symbol.Name);
+						for(let meth of type ? type.Methods : []){
+							let mComp = new vscode.CompletionItem(meth.Name, vscode.CompletionItemKind.Method);
+							mComp.detail = meth.ReturnType + " " + meth.Name + "(";
+							meth.Params.forEach(param => {
+								mComp.detail += param.Type + " " + param.Name + ", ";
+							});
+							mComp.detail += ")";
+							mComp.commitCharacters = ['(', ' '];
+							completions.push(mComp);
+						}
+					}else if(symbol.Kind === 'Enum'){
+						let comp = new vscode.CompletionItem(symbol.Name, vscode.CompletionItemKind.Constant);
+						comp.commitCharacters = ['::'];
+						completions.push(comp);
+					}else if(symbol.Kind === 'Variable'){
+						let comp = new vscode.CompletionItem(symbol.Name, vscode.CompletionItemKind.Value);
+						comp.commitCharacters = [];
+						completions.push(comp);
 					}
-				});
-	
-				moduleObject.Enums.forEach(e => {
-					let comp = new vscode.CompletionItem(e.Name, vscode.CompletionItemKind.Constant);
-					comp.commitCharacters = ['::'];
-					completions.push(comp);
-				});
-
-				moduleObject.GlobalVariables.forEach(v => {
-					let comp = new vscode.CompletionItem(v.Name, vscode.CompletionItemKind.Value);
-					comp.commitCharacters = [];
-					completions.push(comp);
-				});
+				}
 			}
 
 			completions.push({label:'for',kind:vscode.CompletionItemKind.Function});
@@ -333,8 +420,7 @@ export function activate(context: vscode.ExtensionContext) {
 			}
 			var fs = require('fs');
 			var interfaceObject;
-			var interfaceJSON = fs.readFileSync(interfaceFile);
-			interfaceObject = JSON.parse(interfaceJSON);
+			interfaceObject = readJSONCached(interfaceFile);
 			//find function
 			let signHelp = new vscode.SignatureHelp();
 			let i = 0;
@@ -382,40 +468,57 @@ export function activate(context: vscode.ExtensionContext) {
 			if(interfaceFile === ''){
 				return null;
 			}
-			var fs = require('fs');
-			var interfaceObject;
-			var interfaceJSON = fs.readFileSync(interfaceFile);
-			interfaceObject = JSON.parse(interfaceJSON);
-
-			interfaceObject.GlobalEnums.forEach(e => {
-				if(e.Name === ident){
-					e.Values.forEach(v => {
-						let comp = new vscode.CompletionItem(v.Name, vscode.CompletionItemKind.EnumMember);
+			if(nativeCompiler && nativeCompiler.complete){
+				//enum values use their enum as namespace in the symbol index
+				for(let symbol of nativeCompiler.complete(interfaceFile, '', ident)){
+					if(symbol.Kind === 'EnumValue'){
+						completions.push(new vscode.CompletionItem(symbol.Name, vscode.CompletionItemKind.EnumMember));
+					}else if(symbol.Kind === 'Function'){
+						let comp = new vscode.CompletionItem(symbol.Name, vscode.CompletionItemKind.Function);
+						comp.detail = symbol.Declaration;
+						comp.commitCharacters = ['('];
 						completions.push(comp);
-					});
+					}else if(symbol.Kind === 'Type'){
+						let comp = new vscode.CompletionItem(symbol.Name, vscode.CompletionItemKind.Class);
+						comp.commitCharacters = ['('];
+						completions.push(comp);
+					}
 				}
-			});
+			}else{
+				var fs = require('fs');
+				var interfaceObject;
+				interfaceObject = readJSONCached(interfaceFile);
 
-			interfaceObject.GlobalFunctions.forEach(func => {
-				if(func.Namespace === ident){
-					let comp = new vscode.CompletionItem(func.Name, vscode.CompletionItemKind.Function);
-					comp.detail = func.ReturnType + " " + func.Name + "(";
-					func.Params.forEach(param => {
-						comp.detail += param.Type + " " + param.Name + ", ";
-					});
-					comp.detail += ")";
-					comp.commitCharacters = ['('];
-					completions.push(comp);
-				}
-			});
+				interfaceObject.GlobalEnums.forEach(e => {
+					if(e.Name === ident){
+						e.Values.forEach(v => {
+							let comp = new vscode.CompletionItem(v.Name, vscode.CompletionItemKind.EnumMember);
+							completions.push(comp);
+						});
+					}
+				});
 
-			interfaceObject.GlobalTypes.forEach(type => {
-				if(type.Namespace === ident){
-					let comp = new vscode.CompletionItem(type.Name, vscode.CompletionItemKind.Class);
-					comp.commitCharacters = ['('];
-					completions.push(comp);
-				}
-			});
+				interfaceObject.GlobalFunctions.forEach(func => {
+					if(func.Namespace === ident){
+						let comp = new vscode.CompletionItem(func.Name, vscode.CompletionItemKind.Function);
+						comp.detail = func.ReturnType + " " + func.Name + "(";
+						func.Params.forEach(param => {
+							comp.detail += param.Type + " " + param.Name + ", ";
+						});
+						comp.detail += ")";
+						comp.commitCharacters = ['('];
+						completions.push(comp);
+					}
+				});
+
+				interfaceObject.GlobalTypes.forEach(type => {
+					if(type.Namespace === ident){
+						let comp = new vscode.CompletionItem(type.Name, vscode.CompletionItemKind.Class);
+						comp.commitCharacters = ['('];
+						completions.push(comp);
+					}
+				});
+			}
 			
 			// return all completion items as array
 			return completions;
@@ -437,16 +540,11 @@ export function activate(context: vscode.ExtensionContext) {
 					return null;
 				}
 
-				var path = require('path');
-				var fs = require('fs');
-				//Cache in memory somewhere?
-				let cachedModuleFile = moduleCache + path.parse(document.fileName).name + '.json';
-				let moduleJSON = fs.readFileSync(cachedModuleFile);
-				let moduleObject = JSON.parse(moduleJSON);
+				let reflection = loadModuleReflection(moduleCache, document.fileName);
 				//Find type
 				var type = '';
-				for(let v of moduleObject.GlobalVariables){
-					if(v.Name === ident){
+				for(let v of reflection.symbols){
+					if(v.Kind === 'Variable' && v.Name === ident){
 						type = v.Type;
 						break;
 					}
@@ -459,24 +557,22 @@ export function activate(context: vscode.ExtensionContext) {
 				}
 				//Find type information
 				let found = false;
-				for(let t of moduleObject.Types){
-					if(t.Name === type){
-						found = true;
-						for(let p of t.Properties){
-							let comp = new vscode.CompletionItem(p.Name, vscode.CompletionItemKind.Property);
-							completions.push(comp);
-						}
-						for(let m of t.Methods){
-							let mComp = new vscode.CompletionItem(m.Name, vscode.CompletionItemKind.Method);
-							mComp.detail = m.ReturnType + " " + m.Name + "(";
-							m.Params.forEach(param => {
-								mComp.detail += param.Type + " " + param.Name + ", ";
-							});
-							mComp.detail += ")";
-							mComp.commitCharacters = ['(', ' '];
-							completions.push(mComp);
-						}
-						break;
+				let t = reflection.findType(type);
+				if(t){
+					found = true;
+					for(let p of t.Properties){
+						let comp = new vscode.CompletionItem(p.Name, vscode.CompletionItemKind.Property);
+						completions.push(comp);
+					}
+					for(let m of t.Methods){
+						let mComp = new vscode.CompletionItem(m.Name, vscode.CompletionItemKind.Method);
+						mComp.detail = m.ReturnType + " " + m.Name + "(";
+						m.Params.forEach(param => {
+							mComp.detail += param.Type + " " + param.Name + ", ";
+						});
+						mComp.detail += ")";
+						mComp.commitCharacters = ['(', ' '];
+						completions.push(mComp);
 					}
 				}
 				if(!found){
@@ -484,8 +580,7 @@ export function activate(context: vscode.ExtensionContext) {
 					let interfaceFile = settings['interfaceLocation'];
 					var fs = require('fs');
 					var interfaceObject;
-					var interfaceJSON = fs.readFileSync(interfaceFile);
-					interfaceObject = JSON.parse(interfaceJSON);
+					interfaceObject = readJSONCached(interfaceFile);
 					//Find type information
 					for(let t of interfaceObject.GlobalTypes){
 						if(t.Name === type){
@@ -523,52 +618,30 @@ export function activate(context: vscode.ExtensionContext) {
 			const tokensBuilder = new vscode.SemanticTokensBuilder(legend);
 			
 			if(moduleCache){
-				var path = require('path');
-				var fs = require('fs');
-				//Cache in memory somewhere?
-				let cachedModuleFile = moduleCache + path.parse(document.fileName).name + '.json';
-				let moduleJSON = fs.readFileSync(cachedModuleFile);
-				let moduleObject = JSON.parse(moduleJSON);
+				let reflection = loadModuleReflection(moduleCache, document.fileName);
+				let tokenKinds = new Map<string, string>();
+				for(let symbol of reflection.symbols){
+					if(symbol.Kind === 'Function'){
+						tokenKinds.set(symbol.Name, 'function');
+					}else if(symbol.Kind === 'Type'){
+						tokenKinds.set(symbol.Name, 'class');
+					}else if(symbol.Kind === 'Enum'){
+						tokenKinds.set(symbol.Name, 'enum');
+					}
+				}
 
 				let iterator = new ForwardIterator(document, 0, 0);
 				let ident = readIdentF(iterator);
 				while(ident !== '' && iterator.lineNumber !== -1){
-					
-					for(let f of moduleObject.Functions){
-						if(f.Name === ident){
-							tokensBuilder.push(
-								new vscode.Range(
-									new vscode.Position(iterator.lineNumber, iterator.offset - ident.length - 1),
-									new vscode.Position(iterator.lineNumber, iterator.offset - 1)),
-									'function',
-									['declaration']
-								);
-							break;
-						}
-					}
-					for(let f of moduleObject.Types){
-						if(f.Name === ident){
-							tokensBuilder.push(
-								new vscode.Range(
-									new vscode.Position(iterator.lineNumber, iterator.offset - ident.length - 1),
-									new vscode.Position(iterator.lineNumber, iterator.offset - 1)),
-									'class',
-									['declaration']
-								);
-							break;
-						}
-					}
-					for(let f of moduleObject.Enums){
-						if(f.Name === ident){
-							tokensBuilder.push(
-								new vscode.Range(
-									new vscode.Position(iterator.lineNumber, iterator.offset - ident.length - 1),
-									new vscode.Position(iterator.lineNumber, iterator.offset - 1)),
-									'enum',
-									['declaration']
-								);
-							break;
-						}
+					let kind = tokenKinds.get(ident);
+					if(kind){
+						tokensBuilder.push(
+							new vscode.Range(
+								new vscode.Position(iterator.lineNumber, iterator.offset - ident.length - 1),
+								new vscode.Position(iterator.lineNumber, iterator.offset - 1)),
+								kind,
+								['declaration']
+							);
 					}
 					try{
 						ident = readIdentF(iterator);
@@ -599,73 +672,91 @@ export function activate(context: vscode.ExtensionContext) {
 
 	const diagCollection = vscode.languages.createDiagnosticCollection('ash');
 
-	const buildDiagnostics = async function(ashLocation:string, moduleCache:string, interfaceFile:string, file:string){
+	const runCompiler = async function(ashLocation:string, moduleCache:string, interfaceFile:string, file:string){
+		var path = require('path');
+		let settings = vscode.workspace.getConfiguration('angelscript_helper');
+		let defines : string[] = settings['defines'] || [];
+		let includeHandler : string = settings['includeHandler'] || '';
+		if(nativeCompiler){
+			let options = { Defines: defines, IncludeHandler: includeHandler };
+			if(moduleCache){
+				return nativeCompiler.reflect(file, interfaceFile, moduleCache + path.parse(file).name + '.json', true, options);
+			}
+			return nativeCompiler.compile(file, interfaceFile, options);
+		}
 		let commandLine = ashLocation + ' -c -s ' + file + ' -i ' + interfaceFile;
+		for(let define of defines){
+			commandLine += ' -d ' + define;
+		}
+		if(includeHandler){
+			commandLine += ' -ih ' + includeHandler;
+		}
 		if(moduleCache){
-			var path = require('path');
-			commandLine += ' -r ' + moduleCache + path.parse(file).name + '.json';
+			commandLine += ' --shard -r ' + moduleCache + path.parse(file).name + '.json';
 		}
 		let { stdout, stderr } = await exec(commandLine, { });
-		if(stderr){
+		if(stderr || !stdout || stdout === 'Missing source file'){
+			return undefined;
+		}
+		return JSON.parse(stdout);
+	};
+
+	const buildDiagnostics = async function(ashLocation:string, moduleCache:string, interfaceFile:string, file:string){
+		let resultObjects = await runCompiler(ashLocation, moduleCache, interfaceFile, file);
+		if(!resultObjects){
 			return;
 		}
 		diagCollection.clear();
-		if(stdout){
-			if(stdout === 'Missing source file'){
-				return;
-			}
-			let resultObjects = JSON.parse(stdout);
-			if(resultObjects){
-				let sectionProblems : Map<string, vscode.Diagnostic[]> = new Map<string, vscode.Diagnostic[]>();
-				resultObjects.Warnings.forEach(w => {
-					let line = w.Line - 1 < 0 ? 0 : w.Line - 1;
-					let column = w.Column - 1 < 0 ? 0 : w.Column - 1;
-					let range = new vscode.Range(new vscode.Position(line, column), new vscode.Position(line, column + 1));
-					let currentDocument = vscode.Uri.file(w.Section);
-					vscode.workspace.openTextDocument(currentDocument).then((doc:vscode.TextDocument) => {
-						if(doc){
-							let ident = readIdent(new ForwardIterator(doc, column, line));
-							range = new vscode.Range(range.start, new vscode.Position(line, column + ident.length));
-						}
-					});
-					let diag = new vscode.Diagnostic(range, w.Message, vscode.DiagnosticSeverity.Warning);
-					let location = new vscode.Location(w.Section, range);
-					diag.relatedInformation?.push(new vscode.DiagnosticRelatedInformation(location, w.Message));
-					if(!sectionProblems.has(w.Section)){
-						sectionProblems.set(w.Section, []);
-					}
-					let problems = sectionProblems.get(w.Section);
-					if(problems){
-						problems.push(diag);
+		if(resultObjects){
+			let sectionProblems : Map<string, vscode.Diagnostic[]> = new Map<string, vscode.Diagnostic[]>();
+			resultObjects.Warnings.forEach(w => {
+				let line = w.Line - 1 < 0 ? 0 : w.Line - 1;
+				let column = w.Column - 1 < 0 ? 0 : w.Column - 1;
+				let range = new vscode.Range(new vscode.Position(line, column), new vscode.Position(line, column + 1));
+				let currentDocument = vscode.Uri.file(w.Section);
+				vscode.workspace.openTextDocument(currentDocument).then((doc:vscode.TextDocument) => {
+					if(doc){
+						let ident = readIdent(new ForwardIterator(doc, column, line));
+						range = new vscode.Range(range.start, new vscode.Position(line, column + ident.length));
 					}
 				});
+				let diag = new vscode.Diagnostic(range, w.Message, vscode.DiagnosticSeverity.Warning);
+				let location = new vscode.Location(w.Section, range);
+				diag.relatedInformation?.push(new vscode.DiagnosticRelatedInformation(location, w.Message));
+				if(!sectionProblems.has(w.Section)){
+					sectionProblems.set(w.Section, []);
+				}
+				let problems = sectionProblems.get(w.Section);
+				if(problems){
+					problems.push(diag);
+				}
+			});
 
-				resultObjects.Errors.forEach(e => {
-					let line = e.Line - 1 < 0 ? 0 : e.Line - 1;
-					let column = e.Column - 1 < 0 ? 0 : e.Column - 1;
-					let range = new vscode.Range(new vscode.Position(line, column), new vscode.Position(line, column + 1));
-					let currentDocument = vscode.Uri.file(e.Section);
-					vscode.workspace.openTextDocument(currentDocument).then((doc:vscode.TextDocument) => {
-						if(doc){
-							let ident = readIdent(new ForwardIterator(doc, column, line));
-							range = new vscode.Range(range.start, new vscode.Position(line, column + ident.length));
-						}
-					});
-					let diag = new vscode.Diagnostic(range, e.Message, vscode.DiagnosticSeverity.Error);
-					let location = new vscode.Location(e.Section, range);
-					diag.relatedInformation?.push(new vscode.DiagnosticRelatedInformation(location, e.Message));
-					if(!sectionProblems.has(e.Section)){
-						sectionProblems.set(e.Section, []);
-					}
-					let problems = sectionProblems.get(e.Section);
-					if(problems){
-						problems.push(diag);
+			resultObjects.Errors.forEach(e => {
+				let line = e.Line - 1 < 0 ? 0 : e.Line - 1;
+				let column = e.Column - 1 < 0 ? 0 : e.Column - 1;
+				let range = new vscode.Range(new vscode.Position(line, column), new vscode.Position(line, column + 1));
+				let currentDocument = vscode.Uri.file(e.Section);
+				vscode.workspace.openTextDocument(currentDocument).then((doc:vscode.TextDocument) => {
+					if(doc){
+						let ident = readIdent(new ForwardIterator(doc, column, line));
+						range = new vscode.Range(range.start, new vscode.Position(line, column + ident.length));
 					}
 				});
-
-				for(let entry of sectionProblems.entries()){
-					diagCollection.set( vscode.Uri.file(entry[0]), entry[1]);
+				let diag = new vscode.Diagnostic(range, e.Message, vscode.DiagnosticSeverity.Error);
+				let location = new vscode.Location(e.Section, range);
+				diag.relatedInformation?.push(new vscode.DiagnosticRelatedInformation(location, e.Message));
+				if(!sectionProblems.has(e.Section)){
+					sectionProblems.set(e.Section, []);
+				}
+				let problems = sectionProblems.get(e.Section);
+				if(problems){
+					problems.push(diag);
 				}
+			});
+
+			for(let entry of sectionProblems.entries()){
+				diagCollection.set( vscode.Uri.file(entry[0]), entry[1]);
 			}
 		}
 	};